@@ -0,0 +1,508 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../error.h"
+#include "../simulation.h"
+
+// Baseline used when no path is given (relative to the root of the repository)
+#define DEFAULT_BASELINE "bench/baseline.json"
+
+// A case fails if it is slower than the baseline by more than this ratio
+#define DEFAULT_TOLERANCE 0.25
+
+// Number of cell updates a case should take (the number of generations is derived from it)
+#define CELLS_PER_CASE ((double)(1 << 30))
+
+// Limits of the number of generations of a case
+#define MIN_GENERATIONS 10
+#define MAX_GENERATIONS 1000
+
+// A case is repeated until it took this long in total (the median run is reported)
+#define MIN_CASE_SECONDS 0.5
+
+// Minimum number of runs of a case
+#define MIN_RUNS 7
+
+// Maximum number of runs of a case
+#define MAX_RUNS 101
+
+// Maximum number of cases
+#define MAX_CASES 64
+
+// Starting state of a benchmark
+typedef enum pattern{
+    pattern_soup,       // Random 50% soup on the whole map
+    pattern_rpentomino, // R-pentomino in the center
+    pattern_gosper,     // Gosper glider gun in the top left corner
+    pattern_sparse,     // A glider in every 256x256 area
+    num_of_patterns
+} pattern;
+
+// Result of a benchmark case
+typedef struct Result{
+    pattern pattern;     // Starting state
+    int size;            // Width and height of the map
+    int generations;     // Number of generations calculated
+    double nsPerCell;    // Time of a cell update in nanoseconds
+    double gensPerSec;   // Generations per second
+} Result;
+
+// Baseline of a benchmark case
+typedef struct Baseline{
+    char pattern[32];    // Name of the starting state
+    int size;            // Width and height of the map
+    double nsPerCell;    // Time of a cell update in nanoseconds
+} Baseline;
+
+// Settings of the benchmark
+typedef struct BenchOptions{
+    step_kernel kernel;          // Implementation of the simulation step (--kernel=NAME)
+    bool kernelGiven;            // The kernel was selected on the command line (otherwise the baseline's kernel is used)
+    Rule rule;                   // Rule of the simulation (--rule=B/S)
+    int threads;                 // Number of simulation threads (--threads=N)
+    int maxSize;                 // Largest map size (--max-size=N)
+    double tolerance;            // Allowed slowdown compared to the baseline (--tolerance=RATIO)
+    bool failOnRegression;       // A slower case is an error, not only reported (--fail-on-regression)
+    const char * baseline;       // Baseline to compare with (--baseline=PATH)
+    const char * writeBaseline;  // Save the results as a new baseline (--write-baseline=PATH)
+} BenchOptions;
+
+// Sizes of the maps
+static const int sizes[] = {256, 1024, 4096, 16384};
+
+// Gosper glider gun
+static const char * gosperGun[] = {
+    "........................O...........",
+    "......................O.O...........",
+    "............OO......OO............OO",
+    "...........O...O....OO............OO",
+    "OO........O.....O...OO..............",
+    "OO........O...O.OO....O.O...........",
+    "..........O.....O.......O...........",
+    "...........O...O....................",
+    "............OO......................"
+};
+
+// R-pentomino
+static const char * rPentomino[] = {
+    ".OO",
+    "OO.",
+    ".O."
+};
+
+// Glider
+static const char * glider[] = {
+    ".O.",
+    "..O",
+    "OOO"
+};
+
+// After a failed attempt to allocate memory,
+// print error message and exit the program
+void notEnoughMemory(){
+    printf("Memory allocation failed!\n");
+    exit(1);
+}
+
+// Name of the pattern (used in the output and in the baseline)
+// Return: Name of the pattern
+static const char * patternName(pattern p){
+    switch(p){
+        case pattern_soup:
+            return "soup";
+        case pattern_rpentomino:
+            return "r-pentomino";
+        case pattern_gosper:
+            return "gosper-gun";
+        case pattern_sparse:
+            return "sparse";
+        default:
+            return "unknown";
+    }
+}
+
+// Fixed seed random number generator (xorshift64), so every run calculates the same boards
+// Return: Next random number
+static uint64_t nextRandom(uint64_t * state){
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Place a pattern on the map with its top left corner at the given position
+static void placePattern(Simulation * sim, const char ** rows, int numOfRows, int x, int y){
+    for(int i = 0; i < numOfRows; i++){
+        for(int j = 0; rows[i][j] != '\0'; j++){
+            if(rows[i][j] == 'O' && x + j < sim->size.width && y + i < sim->size.height){
+                setCell(&sim->map, x + j, y + i, 1);
+            }
+        }
+    }
+}
+
+// Fill the map with the starting state
+static void generatePattern(Simulation * sim, pattern p){
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    uint64_t * row;
+    int size = sim->size.width;
+    
+    switch(p){
+        case pattern_soup:
+            for(int y = 0; y < sim->map.height; y++){
+                row = mapRow(&sim->map, y);
+                for(int w = 0; w < sim->map.words; w++){
+                    row[w] = nextRandom(&seed);
+                }
+                row[sim->map.words - 1] &= lastWordMask(&sim->map);
+            }
+            break;
+        case pattern_rpentomino:
+            placePattern(sim, rPentomino, 3, size / 2 - 1, size / 2 - 1);
+            break;
+        case pattern_gosper:
+            placePattern(sim, gosperGun, 9, 16, 16);
+            break;
+        case pattern_sparse:
+            for(int y = 0; y < size; y += 256){
+                for(int x = 0; x < size; x += 256){
+                    placePattern(sim, glider, 3, x + nextRandom(&seed) % 253, y + nextRandom(&seed) % 253);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    markAllTilesChanged(sim);
+}
+
+// Number of generations of a case (smaller maps run more generations)
+// Return: Number of generations
+static int generationsOfSize(int size){
+    double generations = CELLS_PER_CASE / ((double)size * size);
+    if(generations < MIN_GENERATIONS){
+        return MIN_GENERATIONS;
+    }
+    if(generations > MAX_GENERATIONS){
+        return MAX_GENERATIONS;
+    }
+    return (int)generations;
+}
+
+// Compare two run times (used to sort them)
+// Return: Negative, zero or positive like strcmp
+static int compareSeconds(const void * a, const void * b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Time the simulation of a pattern on a map of the given size
+// Return: Result
+static Result runCase(const BenchOptions * options, ThreadPool * pool, pattern p, int size){
+    Result result;
+    Simulation sim = simulation_init(size, size);
+    Uint64 start, end;
+    double seconds[MAX_RUNS], median, total = 0;
+    int runs = 0;
+    
+    sim.kernel = options->kernel;
+    sim.rule = options->rule;
+    sim.pool = pool;
+    
+    result.pattern = p;
+    result.size = size;
+    result.generations = generationsOfSize(size);
+    // Single runs are noisy, so the case is repeated and the median run is kept
+    while(runs < MAX_RUNS && (runs < MIN_RUNS || total < MIN_CASE_SECONDS)){
+        clearMap(&sim.map);
+        generatePattern(&sim, p);
+        start = SDL_GetPerformanceCounter();
+        for(int i = 0; i < result.generations; i++){
+            cycle(&sim);
+        }
+        end = SDL_GetPerformanceCounter();
+        seconds[runs] = (double)(end - start) / SDL_GetPerformanceFrequency();
+        total += seconds[runs];
+        runs++;
+    }
+    qsort(seconds, runs, sizeof(double), compareSeconds);
+    median = runs % 2 == 1 ? seconds[runs / 2] : (seconds[runs / 2 - 1] + seconds[runs / 2]) / 2;
+    result.nsPerCell = median * 1e9 / ((double)result.generations * size * size);
+    result.gensPerSec = median > 0 ? result.generations / median : 0;
+    
+    sim.pool = NULL;
+    simulation_free(&sim);
+    return result;
+}
+
+// Find the value of a field in a JSON object
+// Return: Pointer to the value, or NULL if the object doesn't have the field
+static const char * jsonField(const char * object, const char * end, const char * name){
+    char key[64];
+    const char * found;
+    snprintf(key, sizeof(key), "\"%s\"", name);
+    found = strstr(object, key);
+    if(found == NULL || found >= end){
+        return NULL;
+    }
+    found = strchr(found + strlen(key), ':');
+    if(found == NULL || found >= end){
+        return NULL;
+    }
+    found++;
+    while(*found == ' ' || *found == '\t' || *found == '\r' || *found == '\n'){
+        found++;
+    }
+    return found;
+}
+
+// Load the baseline
+// (it only understands the flat format written by writeBaselineFile())
+// kernel: name of the kernel the baseline was measured with
+// threads: number of threads the baseline was measured with (0 if the file doesn't tell)
+// Return: Number of cases, or -1 if the file can't be read
+static int loadBaseline(const char * path, Baseline * baseline, int maxCases, char kernel[32], int * threads){
+    FILE * fp = fopen(path, "rb");
+    const char * object, * end, * value;
+    char * text;
+    long length;
+    int numOfCases = 0;
+    
+    if(fp == NULL){
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    text = malloc(length + 1);
+    if(text == NULL){
+        notEnoughMemory();
+    }
+    length = fread(text, 1, length, fp);
+    text[length] = '\0';
+    fclose(fp);
+    
+    kernel[0] = '\0';
+    value = jsonField(text, text + length, "kernel");
+    if(value != NULL){
+        sscanf(value, "\"%31[^\"]\"", kernel);
+    }
+    *threads = 0;
+    value = jsonField(text, text + length, "threads");
+    if(value != NULL){
+        sscanf(value, "%d", threads);
+    }
+    
+    // Every object with a pattern field is a case
+    object = text;
+    while(numOfCases < maxCases && (object = strstr(object, "\"pattern\"")) != NULL){
+        end = strchr(object, '}');
+        if(end == NULL){
+            break;
+        }
+        Baseline * b = &baseline[numOfCases];
+        value = jsonField(object, end, "pattern");
+        if(value != NULL && sscanf(value, "\"%31[^\"]\"", b->pattern) == 1 &&
+           (value = jsonField(object, end, "size")) != NULL && sscanf(value, "%d", &b->size) == 1 &&
+           (value = jsonField(object, end, "nsPerCell")) != NULL && sscanf(value, "%lf", &b->nsPerCell) == 1){
+            numOfCases++;
+        }
+        object = end;
+    }
+    free(text);
+    return numOfCases;
+}
+
+// Save the results as a baseline
+// Return: TRUE on success, FALSE if the file can't be opened
+static bool writeBaselineFile(const char * path, const BenchOptions * options, int threads,
+                              const Result * results, int numOfResults){
+    FILE * fp = fopen(path, "wb");
+    if(fp == NULL){
+        return false;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"kernel\": \"%s\",\n", kernelName(options->kernel));
+    fprintf(fp, "  \"threads\": %d,\n", threads);
+    fprintf(fp, "  \"results\": [\n");
+    for(int i = 0; i < numOfResults; i++){
+        fprintf(fp, "    {\"pattern\": \"%s\", \"size\": %d, \"nsPerCell\": %.6f, \"gensPerSec\": %.1f}%s\n",
+                patternName(results[i].pattern), results[i].size, results[i].nsPerCell,
+                results[i].gensPerSec, i + 1 < numOfResults ? "," : "");
+    }
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+    fclose(fp);
+    return true;
+}
+
+// Find the baseline of a case
+// Return: Pointer to the baseline, or NULL if the case is not in the baseline
+static const Baseline * findBaseline(const Baseline * baseline, int numOfCases, const Result * result){
+    for(int i = 0; i < numOfCases; i++){
+        if(strcmp(baseline[i].pattern, patternName(result->pattern)) == 0 && baseline[i].size == result->size){
+            return &baseline[i];
+        }
+    }
+    return NULL;
+}
+
+// Print the accepted command line options
+static void printBenchUsage(const char * program){
+    printf("Usage: %s [options]\n", program);
+    printf("  --kernel=NAME          Simulation step: scalar, bitwise, avx2, avx512 (default: the kernel of the baseline, or the fastest)\n");
+    printf("  --rule=B/S             Rule of the simulation (default: B3/S23)\n");
+    printf("  --threads=N            Number of simulation threads, 0: processor cores (default: 1)\n");
+    printf("  --max-size=N           Largest map size (default: 16384)\n");
+    printf("  --tolerance=RATIO      Allowed slowdown compared to the baseline (default: 0.25)\n");
+    printf("  --fail-on-regression   Exit with an error if a case is slower than the tolerance (default: only report it)\n");
+    printf("  --baseline=PATH        Baseline to compare with (default: %s)\n", DEFAULT_BASELINE);
+    printf("  --write-baseline=PATH  Save the results as a new baseline\n");
+}
+
+// Get the value of an option in the form of --name=value
+// Return: The value, or NULL if the argument is not the given option
+static const char * optionValue(const char * arg, const char * name){
+    size_t length = strlen(name);
+    if(strncmp(arg, name, length) == 0 && arg[length] == '='){
+        return arg + length + 1;
+    }
+    return NULL;
+}
+
+// Parse the command line options
+// Unknown or invalid options print the usage and exit the program
+// Return: BenchOptions
+static BenchOptions parseBenchOptions(int argc, char * argv[]){
+    BenchOptions options;
+    const char * value;
+    options.kernel = bestKernel();
+    options.kernelGiven = false;
+    options.rule = RULE_CONWAY;
+    options.threads = 1;
+    options.maxSize = 16384;
+    options.tolerance = DEFAULT_TOLERANCE;
+    options.failOnRegression = false;
+    options.baseline = DEFAULT_BASELINE;
+    options.writeBaseline = NULL;
+    
+    for(int i = 1; i < argc; i++){
+        if((value = optionValue(argv[i], "--kernel")) != NULL){
+            if(!parseKernelName(value, &options.kernel) || !kernelSupported(options.kernel)){
+                printf("Unknown or unsupported kernel: %s\n", value);
+                printBenchUsage(argv[0]);
+                exit(1);
+            }
+            options.kernelGiven = true;
+        } else if((value = optionValue(argv[i], "--rule")) != NULL){
+            if(!parseRule(value, &options.rule)){
+                printf("Invalid rule: %s\n", value);
+                printBenchUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--threads")) != NULL){
+            options.threads = atoi(value);
+        } else if((value = optionValue(argv[i], "--max-size")) != NULL){
+            options.maxSize = atoi(value);
+        } else if((value = optionValue(argv[i], "--tolerance")) != NULL){
+            options.tolerance = atof(value);
+        } else if(strcmp(argv[i], "--fail-on-regression") == 0){
+            options.failOnRegression = true;
+        } else if((value = optionValue(argv[i], "--baseline")) != NULL){
+            options.baseline = value;
+        } else if((value = optionValue(argv[i], "--write-baseline")) != NULL){
+            options.writeBaseline = value;
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printBenchUsage(argv[0]);
+            exit(1);
+        }
+    }
+    if(options.threads < 0 || options.maxSize < sizes[0] || options.tolerance < 0){
+        printf("Invalid option value\n");
+        printBenchUsage(argv[0]);
+        exit(1);
+    }
+    return options;
+}
+
+// Run every case, print the results and compare them with the baseline
+// Return: 0 if no case is slower than the baseline (or the regressions are only reported), 1 otherwise
+int main(int argc, char * argv[]){
+    BenchOptions options = parseBenchOptions(argc, argv);
+    ThreadPool * pool = NULL;
+    Result results[MAX_CASES];
+    Baseline baseline[MAX_CASES];
+    char baselineKernel[32];
+    step_kernel kernel;
+    char rule[RULE_NAME_LENGTH];
+    const Baseline * base;
+    int numOfResults = 0, numOfBaseline, baselineThreads, regressions = 0;
+    int threads;
+    double ratio;
+    
+    // The threads are started once and shared by the cases
+    threads = options.threads > 0 ? options.threads : SDL_GetCPUCount();
+    if(threads > 1){
+        pool = threadpool_init(threads);
+    }
+    
+    numOfBaseline = loadBaseline(options.baseline, baseline, MAX_CASES, baselineKernel, &baselineThreads);
+    if(numOfBaseline >= 0 && !options.kernelGiven && parseKernelName(baselineKernel, &kernel) && kernelSupported(kernel)){
+        // The same kernel is measured as the baseline, so the fastest kernel of the machine doesn't change the result
+        options.kernel = kernel;
+    }
+    if(numOfBaseline < 0){
+        printf("Baseline %s can't be read, the results are not compared\n", options.baseline);
+    } else if(strcmp(baselineKernel, kernelName(options.kernel)) != 0 || (baselineThreads > 0 && baselineThreads != threads)){
+        // Different kernels (or numbers of threads) don't have comparable times
+        printf("The baseline was measured with the %s kernel on %d thread(s), the results are not compared\n",
+               baselineKernel, baselineThreads);
+        numOfBaseline = 0;
+    }
+    
+    ruleName(options.rule, rule);
+    printf("Kernel: %s, rule: %s, threads: %d\n", kernelName(options.kernel), rule, threads);
+    printf("%-12s %6s %6s %10s %12s %10s  %s\n", "pattern", "size", "gens", "ns/cell", "gens/s", "baseline", "status");
+    for(int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])) && sizes[s] <= options.maxSize; s++){
+        for(pattern p = 0; p < num_of_patterns; p++){
+            Result * r = &results[numOfResults++];
+            *r = runCase(&options, pool, p, sizes[s]);
+            base = numOfBaseline > 0 ? findBaseline(baseline, numOfBaseline, r) : NULL;
+            printf("%-12s %6d %6d %10.4f %12.1f ", patternName(r->pattern), r->size, r->generations,
+                   r->nsPerCell, r->gensPerSec);
+            if(base == NULL){
+                printf("%10s  -\n", "-");
+            } else {
+                ratio = r->nsPerCell / base->nsPerCell;
+                if(ratio > 1 + options.tolerance){
+                    regressions++;
+                    printf("%10.4f  REGRESSION (%.0f%% slower)\n", base->nsPerCell, (ratio - 1) * 100);
+                } else {
+                    printf("%10.4f  ok (%+.0f%%)\n", base->nsPerCell, (ratio - 1) * 100);
+                }
+            }
+            fflush(stdout);
+        }
+    }
+    threadpool_destroy(pool);
+    
+    if(options.writeBaseline != NULL){
+        if(writeBaselineFile(options.writeBaseline, &options, threads, results, numOfResults)){
+            printf("Baseline saved to %s\n", options.writeBaseline);
+        } else {
+            printf("Baseline %s can't be saved\n", options.writeBaseline);
+            return 1;
+        }
+    }
+    if(regressions > 0){
+        printf("%d case(s) are slower than the baseline\n", regressions);
+        // Times measured on a busy machine vary a lot, so regressions are only an error when asked for
+        return options.failOnRegression ? 1 : 0;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "error.h"
+#include "bitmap.h"
+
+// Number of rows allocated in front of the first row of the map:
+// a spare row that holds the left guard word of the guard row, and the guard row above
+#define FRONT_ROWS 2
+
+// Set the dimensions of the map and calculate the layout of its rows
+static void setDimensions(Bitmap * map, int width, int height){
+    map->width = width;
+    map->height = height;
+    map->words = (width + WORD_BITS - 1) / WORD_BITS;
+    if(map->words < 1){
+        map->words = 1;
+    }
+    // Leave room for the right guard and the left guard of the next row
+    map->stride = (map->words + 2 + LINE_WORDS - 1) / LINE_WORDS * LINE_WORDS;
+    map->mapped = false;
+}
+
+// Checks if a map with the given dimensions can be allocated
+// (the number of words of its buffer must fit in an int, and its size in bytes in a size_t)
+// Return: TRUE if the dimensions are valid, FALSE otherwise
+bool validDimensions(int width, int height){
+    Bitmap layout;
+    unsigned long long words;
+    if(width < 0 || height < 0 || width > INT_MAX - WORD_BITS){
+        return false;
+    }
+    setDimensions(&layout, width, height);
+    words = ((unsigned long long)height + FRONT_ROWS + 1) * layout.stride + LINE_WORDS;
+    return words <= INT_MAX && words <= SIZE_MAX / sizeof(uint64_t);
+}
+
+// Allocate an empty map with the given dimensions
+// Return: Bitmap
+Bitmap bitmap_init(int width, int height){
+    Bitmap map;
+    uintptr_t aligned;
+    setDimensions(&map, width, height);
+    map.memory = calloc(mapBufferSize(&map) / sizeof(uint64_t) + LINE_WORDS, sizeof(uint64_t));
+    if(map.memory == NULL){
+        notEnoughMemory();
+    }
+    aligned = ((uintptr_t)map.memory + LINE_WORDS * sizeof(uint64_t) - 1) & ~(uintptr_t)(LINE_WORDS * sizeof(uint64_t) - 1);
+    map.cells = (uint64_t *)aligned + (size_t)FRONT_ROWS * map.stride;
+    return map;
+}
+
+// Map a map file into memory with copy-on-write
+// The file holds a header page (BITMAP_FILE_HEADER bytes), then the buffer of a map
+// with the given dimensions (see mapBuffer()). The pages are read from the file when they are
+// first touched, and changes of the map are never written back to the file.
+// Return: TRUE on success, FALSE if the file can't be mapped or it is too short
+bool bitmap_mapFile(Bitmap * map, const char * path, int width, int height){
+    Bitmap layout;
+    unsigned long long size;
+    void * memory = NULL;
+    setDimensions(&layout, width, height);
+    size = BITMAP_FILE_HEADER + ((unsigned long long)height + FRONT_ROWS + 1) * layout.stride * sizeof(uint64_t);
+    if(size != (size_t)size){
+        // Larger than the address space
+        return false;
+    }
+#ifdef _WIN32
+    HANDLE file, mapping;
+    LARGE_INTEGER fileSize;
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+    if(GetFileSizeEx(file, &fileSize) && (unsigned long long)fileSize.QuadPart >= size){
+        // The view keeps the mapping alive after the handles are closed
+        mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if(mapping != NULL){
+            memory = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, (SIZE_T)size);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    struct stat status;
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    if(fstat(fd, &status) == 0 && (unsigned long long)status.st_size >= size){
+        // Private mapping: written pages are copied, the file is not modified
+        memory = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if(memory == MAP_FAILED){
+            memory = NULL;
+        }
+    }
+    close(fd);
+#endif
+    if(memory == NULL){
+        return false;
+    }
+    *map = layout;
+    map->memory = memory;
+    map->cells = (uint64_t *)((char *)memory + BITMAP_FILE_HEADER) + (size_t)FRONT_ROWS * map->stride;
+    map->mapped = true;
+    return true;
+}
+
+// Copy a mapped map into allocated memory and unmap its file
+// (it must be called before the file is overwritten; a map that is not mapped is left as it is)
+void bitmap_unmapFile(Bitmap * map){
+    Bitmap copy;
+    if(!map->mapped){
+        return;
+    }
+    copy = bitmap_init(map->width, map->height);
+    memcpy((void *)mapBuffer(&copy), mapBuffer(map), mapBufferSize(map));
+    bitmap_free(map);
+    *map = copy;
+}
+
+// Frees the memory allocated by the map
+void bitmap_free(Bitmap * map){
+    if(map->mapped){
+#ifdef _WIN32
+        UnmapViewOfFile(map->memory);
+#else
+        munmap(map->memory, BITMAP_FILE_HEADER + mapBufferSize(map));
+#endif
+    } else {
+        free(map->memory);
+    }
+    map->memory = NULL;
+    map->cells = NULL;
+    map->mapped = false;
+}
+
+// Number of bytes allocated by the map
+// Return: Size in bytes
+size_t bitmapSize(const Bitmap * map){
+    if(map->mapped){
+        return BITMAP_FILE_HEADER + mapBufferSize(map);
+    }
+    return mapBufferSize(map) + LINE_WORDS * sizeof(uint64_t);
+}
+
+// Get the beginning of the buffer of the map: the front row, the guard row above,
+// the rows of the map and the guard row below (the layout of the mapped map files)
+// Return: Pointer to the buffer
+const uint64_t * mapBuffer(const Bitmap * map){
+    return map->cells - (size_t)FRONT_ROWS * map->stride;
+}
+
+// Size of the buffer of the map (see mapBuffer())
+// Return: Size in bytes
+size_t mapBufferSize(const Bitmap * map){
+    // Front line, guard row above, the rows of the map, guard row below
+    return ((size_t)map->height + FRONT_ROWS + 1) * map->stride * sizeof(uint64_t);
+}
+
+// Clear the map
+void clearMap(Bitmap * map){
+    memset(mapRow(map, 0), 0, (size_t)map->height * map->stride * sizeof(uint64_t));
+}
+
+// Copy the content of the map to another with the same dimensions
+void copyMap(Bitmap * dst, const Bitmap * src){
+    memcpy(mapRow(dst, 0), mapRow(src, 0), (size_t)src->height * src->stride * sizeof(uint64_t));
+}
+
+// Exchange the content of two maps with the same dimensions
+void swapMaps(Bitmap * a, Bitmap * b){
+    Bitmap tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of cells stored in a word
+#define WORD_BITS 64
+
+// Number of words in a cache line (the rows are aligned to it)
+#define LINE_WORDS 8
+
+// Number of rows in a tile of the map (a tile is one word wide)
+#define TILE_ROWS 64
+
+// Size of the header page in front of the buffer of a mapped map file (in bytes)
+#define BITMAP_FILE_HEADER 4096
+
+// Bit-packed map, one bit per cell
+// The rows are stored in one contiguous buffer. Every row starts on a cache line
+// and it is followed by at least two padding words. The word after the last word of
+// a row and the word before the first word of a row (the last padding word of the previous row)
+// are guard words. There is a guard row above the first and below the last row.
+// Guards are zero, so the neighbours of the cells on the edge can be read without bounds checks.
+// (with the torus and mirror boundaries the step fills them and the bit after the last cell
+// with ghost cells, and clears them again at its end)
+typedef struct Bitmap{
+    int width;          // Number of cells in a row
+    int height;         // Number of rows
+    int words;          // Number of words that hold the cells of a row
+    int stride;         // Distance between the beginning of two rows (in words)
+    void * memory;      // Allocated memory (not aligned), or the beginning of the mapped file
+    uint64_t * cells;   // First word of the first row
+    bool mapped;        // The memory is a copy-on-write mapping of a file (bitmap_free unmaps it)
+} Bitmap;
+
+// Get the first word of the given row
+// Return: Pointer to the row
+static inline uint64_t * mapRow(const Bitmap * map, int y){
+    return map->cells + (intptr_t)y * map->stride;
+}
+
+// Get the state of the cell
+// Return: 1 if the cell is active, 0 otherwise
+static inline int getCell(const Bitmap * map, int x, int y){
+    return (int)((mapRow(map, y)[x >> 6] >> (x & 63)) & 0x1);
+}
+
+// Set the state of the cell
+static inline void setCell(Bitmap * map, int x, int y, int state){
+    uint64_t * word = &mapRow(map, y)[x >> 6];
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    if(state){
+        *word |= bit;
+    } else {
+        *word &= ~bit;
+    }
+}
+
+// Mask of the bits in the last word of a row that belong to the map
+// Return: Bit mask
+static inline uint64_t lastWordMask(const Bitmap * map){
+    int used = map->width - (map->words - 1) * WORD_BITS;
+    return used == WORD_BITS ? ~(uint64_t)0 : (((uint64_t)1 << used) - 1);
+}
+
+// Checks if a map with the given dimensions can be allocated
+// (the number of words of its buffer must fit in an int, and its size in bytes in a size_t)
+// Return: TRUE if the dimensions are valid, FALSE otherwise
+bool validDimensions(int width, int height);
+
+// Allocate an empty map with the given dimensions
+// Return: Bitmap
+Bitmap bitmap_init(int width, int height);
+
+// Map a map file into memory with copy-on-write
+// The file holds a header page (BITMAP_FILE_HEADER bytes), then the buffer of a map
+// with the given dimensions (see mapBuffer()). The pages are read from the file when they are
+// first touched, and changes of the map are never written back to the file.
+// Return: TRUE on success, FALSE if the file can't be mapped or it is too short
+bool bitmap_mapFile(Bitmap * map, const char * path, int width, int height);
+
+// Copy a mapped map into allocated memory and unmap its file
+// (it must be called before the file is overwritten; a map that is not mapped is left as it is)
+void bitmap_unmapFile(Bitmap * map);
+
+// Frees the memory allocated by the map
+void bitmap_free(Bitmap * map);
+
+// Number of bytes allocated by the map
+// Return: Size in bytes
+size_t bitmapSize(const Bitmap * map);
+
+// Get the beginning of the buffer of the map: the front row, the guard row above,
+// the rows of the map and the guard row below (the layout of the mapped map files)
+// Return: Pointer to the buffer
+const uint64_t * mapBuffer(const Bitmap * map);
+
+// Size of the buffer of the map (see mapBuffer())
+// Return: Size in bytes
+size_t mapBufferSize(const Bitmap * map);
+
+// Clear the map
+void clearMap(Bitmap * map);
+
+// Copy the content of the map to another with the same dimensions
+void copyMap(Bitmap * dst, const Bitmap * src);
+
+// Exchange the content of two maps with the same dimensions
+void swapMaps(Bitmap * a, Bitmap * b);
+
+#endif
\ No newline at end of file
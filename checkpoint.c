@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+#include "checkpoint.h"
+
+// Content of the empty tiles (shared by every checkpoint, it is never freed)
+static TileBlock emptyBlock;
+
+// Initialize the checkpoints of a map with the given number of tiles (none of them is taken)
+// Return: Checkpoints
+Checkpoints checkpoints_init(int columns, int rows){
+    Checkpoints cp;
+    memset(&cp, 0, sizeof(cp));
+    cp.columns = columns;
+    cp.rows = rows;
+    // One extra element, so an empty map also gets a valid allocation
+    cp.savedEpoch = calloc((size_t)columns * rows + 1, sizeof(uint32_t));
+    if(cp.savedEpoch == NULL){
+        notEnoughMemory();
+    }
+    return cp;
+}
+
+// Drop a reference to the block, the block is freed when no checkpoint uses it
+static void releaseBlock(TileBlock * block){
+    if(block != &emptyBlock && --block->references == 0){
+        free(block);
+    }
+}
+
+// Drop every saved tile of the checkpoint
+static void clearCheckpoint(Checkpoint * checkpoint, size_t numOfTiles){
+    if(checkpoint->blocks != NULL){
+        for(size_t i = 0; i < numOfTiles && checkpoint->numOfBlocks > 0; i++){
+            if(checkpoint->blocks[i] != NULL){
+                releaseBlock(checkpoint->blocks[i]);
+                checkpoint->numOfBlocks--;
+            }
+        }
+        free(checkpoint->blocks);
+    }
+    checkpoint->blocks = NULL;
+    checkpoint->numOfBlocks = 0;
+    checkpoint->used = false;
+}
+
+// Frees the memory allocated by the checkpoints
+void checkpoints_free(Checkpoints * cp){
+    for(int i = 0; i < MAX_CHECKPOINTS; i++){
+        clearCheckpoint(&cp->slots[i], (size_t)cp->columns * cp->rows);
+    }
+    free(cp->savedEpoch);
+    cp->savedEpoch = NULL;
+}
+
+// Copy the content of a tile of the map into a new block
+// (the unused bits of the last word may hold ghost cells during a step, they are not copied)
+// Return: Pointer to the block (the shared empty block if the tile is empty)
+static TileBlock * copyTile(const Bitmap * map, int tileX, int tileY){
+    uint64_t words[TILE_ROWS];
+    uint64_t population = 0;
+    uint64_t mask = tileX == map->words - 1 ? lastWordMask(map) : ~(uint64_t)0;
+    TileBlock * block;
+    int y;
+    for(int r = 0; r < TILE_ROWS; r++){
+        y = tileY * TILE_ROWS + r;
+        words[r] = y < map->height ? mapRow(map, y)[tileX] & mask : 0;
+        population |= words[r];
+    }
+    if(population == 0){
+        return &emptyBlock;
+    }
+    block = malloc(sizeof(TileBlock));
+    if(block == NULL){
+        notEnoughMemory();
+    }
+    block->references = 0;
+    memcpy(block->words, words, sizeof(words));
+    return block;
+}
+
+// Save the content of the tile for the checkpoints that still share it with the map
+void saveTile(Checkpoints * cp, const Bitmap * map, int tileX, int tileY){
+    size_t tile = (size_t)tileY * cp->columns + tileX;
+    TileBlock * block = NULL;
+    Checkpoint * checkpoint;
+    for(int i = 0; i < MAX_CHECKPOINTS; i++){
+        checkpoint = &cp->slots[i];
+        if(!checkpoint->used || checkpoint->blocks[tile] != NULL){
+            continue;
+        }
+        // The checkpoints that share the tile share the saved copy as well
+        if(block == NULL){
+            block = copyTile(map, tileX, tileY);
+        }
+        if(block != &emptyBlock){
+            block->references++;
+        }
+        checkpoint->blocks[tile] = block;
+        checkpoint->numOfBlocks++;
+    }
+    cp->savedEpoch[tile] = cp->epoch;
+}
+
+// Must be called before the whole map is modified
+void preserveAllTiles(Checkpoints * cp, const Bitmap * map){
+    for(int ty = 0; ty < cp->rows; ty++){
+        for(int tx = 0; tx < cp->columns; tx++){
+            preserveTile(cp, map, tx, ty);
+        }
+    }
+}
+
+// Take a checkpoint of the current state of the map (a previous checkpoint in the slot is replaced)
+void takeCheckpoint(Checkpoints * cp, int slot){
+    Checkpoint * checkpoint = &cp->slots[slot];
+    clearCheckpoint(checkpoint, (size_t)cp->columns * cp->rows);
+    checkpoint->blocks = calloc((size_t)cp->columns * cp->rows + 1, sizeof(TileBlock *));
+    if(checkpoint->blocks == NULL){
+        notEnoughMemory();
+    }
+    checkpoint->used = true;
+    // Every tile is shared with the map until it changes
+    cp->epoch++;
+}
+
+// Copy the tiles saved by the checkpoint back to the map
+// changed, dirty: flags of the tiles, set for every restored tile
+// Return: TRUE on success, FALSE if the checkpoint was not taken
+bool restoreCheckpointTiles(Checkpoints * cp, int slot, Bitmap * map, uint8_t * changed, uint8_t * dirty){
+    Checkpoint * checkpoint = &cp->slots[slot];
+    TileBlock * block;
+    size_t tile;
+    int y;
+    if(!checkpoint->used){
+        return false;
+    }
+    // Only the tiles that changed since the checkpoint are saved, the others are the same on the map
+    for(int ty = 0; ty < cp->rows && checkpoint->numOfBlocks > 0; ty++){
+        for(int tx = 0; tx < cp->columns; tx++){
+            tile = (size_t)ty * cp->columns + tx;
+            block = checkpoint->blocks[tile];
+            if(block == NULL){
+                continue;
+            }
+            // The other checkpoints may still share the current content of the tile
+            preserveTile(cp, map, tx, ty);
+            for(int r = 0; r < TILE_ROWS; r++){
+                y = ty * TILE_ROWS + r;
+                if(y < map->height){
+                    mapRow(map, y)[tx] = block->words[r];
+                }
+            }
+            checkpoint->blocks[tile] = NULL;
+            checkpoint->numOfBlocks--;
+            releaseBlock(block);
+            changed[tile] = 1;
+            dirty[tile] = 1;
+        }
+    }
+    // The checkpoint shares every tile with the map again
+    cp->epoch++;
+    return true;
+}
+
+// Number of bytes allocated by the checkpoints
+// (the shared blocks are counted once for every checkpoint that uses them)
+// Return: Size in bytes
+size_t checkpointsSize(const Checkpoints * cp){
+    size_t size = ((size_t)cp->columns * cp->rows + 1) * sizeof(uint32_t);
+    for(int i = 0; i < MAX_CHECKPOINTS; i++){
+        if(cp->slots[i].used){
+            size += ((size_t)cp->columns * cp->rows + 1) * sizeof(TileBlock *) +
+                    cp->slots[i].numOfBlocks * sizeof(TileBlock);
+        }
+    }
+    return size;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "bitmap.h"
+
+// Number of checkpoints (checkpoint 0 is the state restored by Reset)
+#define MAX_CHECKPOINTS 10
+
+// Checkpoint restored by the Reset button
+#define DEFAULT_CHECKPOINT 0
+
+// Content of a tile saved by checkpoints
+// Checkpoints that saved the same content share the block
+typedef struct TileBlock{
+    int references;             // Number of checkpoints that use the block
+    uint64_t words[TILE_ROWS];  // Word of the tile in each row
+} TileBlock;
+
+// Saved state of the map
+typedef struct Checkpoint{
+    bool used;            // The checkpoint was taken
+    TileBlock ** blocks;  // Saved content of every tile (NULL: the tile did not change since the checkpoint,
+                          // the map still holds its content)
+    size_t numOfBlocks;   // Number of saved tiles
+} Checkpoint;
+
+// Copy-on-write checkpoints of a map
+// A checkpoint shares every tile with the map when it is taken, so taking one only starts a new epoch.
+// The first change of a tile in an epoch saves its content once, for every checkpoint that still shares it.
+typedef struct Checkpoints{
+    int columns;            // Number of tiles in a row
+    int rows;               // Number of tiles in a column
+    uint32_t epoch;         // Incremented when a checkpoint is taken or restored
+    uint32_t * savedEpoch;  // Epoch in which the content of each tile was last saved
+    Checkpoint slots[MAX_CHECKPOINTS];
+} Checkpoints;
+
+// Initialize the checkpoints of a map with the given number of tiles (none of them is taken)
+// Return: Checkpoints
+Checkpoints checkpoints_init(int columns, int rows);
+
+// Frees the memory allocated by the checkpoints
+void checkpoints_free(Checkpoints * cp);
+
+// Save the content of the tile for the checkpoints that still share it with the map
+void saveTile(Checkpoints * cp, const Bitmap * map, int tileX, int tileY);
+
+// Must be called before a tile of the map is modified
+// (tileX: word column of the map, tileY: row of TILE_ROWS rows)
+static inline void preserveTile(Checkpoints * cp, const Bitmap * map, int tileX, int tileY){
+    if(cp->savedEpoch[(size_t)tileY * cp->columns + tileX] != cp->epoch){
+        saveTile(cp, map, tileX, tileY);
+    }
+}
+
+// Must be called before the whole map is modified
+void preserveAllTiles(Checkpoints * cp, const Bitmap * map);
+
+// Take a checkpoint of the current state of the map (a previous checkpoint in the slot is replaced)
+void takeCheckpoint(Checkpoints * cp, int slot);
+
+// Copy the tiles saved by the checkpoint back to the map
+// changed, dirty: flags of the tiles, set for every restored tile
+// Return: TRUE on success, FALSE if the checkpoint was not taken
+bool restoreCheckpointTiles(Checkpoints * cp, int slot, Bitmap * map, uint8_t * changed, uint8_t * dirty);
+
+// Number of bytes allocated by the checkpoints
+// (the shared blocks are counted once for every checkpoint that uses them)
+// Return: Size in bytes
+size_t checkpointsSize(const Checkpoints * cp);
+
+#endif
\ No newline at end of file
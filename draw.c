@@ -1,150 +1,658 @@
-#include <SDL2/SDL.h>
-#include <stdio.h>
-
-#include "draw.h"
-
-// Set the color of the next drawing operation
-void setDrawColor(SDL_Renderer * renderer, SDL_Color const * color){
-    SDL_SetRenderDrawColor(renderer, color->r, color->g, color->b, color->a);
-}
-
-// Draw a line between the two points with the given offset
-void drawLineWithOffset(SDL_Renderer * renderer, Offset * offset, int x1, int y1, int x2, int y2){
-    SDL_RenderDrawLine(renderer, x1 + offset->x, y1 + offset->y, x2 + offset->x, y2 + offset->y);
-}
-
-// Draw a rectangle with offset
-void drawRectWithOffset(SDL_Renderer * renderer, Offset * offset, SDL_Rect * area){
-    area->x += offset->x;
-    area->y += offset->y;
-    SDL_RenderFillRect(renderer, area);
-}
-
-// Get the area of the map on the screen
-// Return: SDL_Rect
-SDL_Rect viewport(Simulation * sim){
-    SDL_Rect area;
-    area.x = sim->offset.x;
-    area.y = sim->offset.y;
-    area.w = sim->size.width * (sim->zoom + 1);
-    area.h = sim->size.height  * (sim->zoom + 1);
-    return area;
-}
-
-// Fill the screen with color_background
-void clearWindow(SDL_Renderer * renderer){
-    setDrawColor(renderer, &color_background);
-    SDL_RenderClear(renderer);
-}
-
-// Clear given area of the screen
-void clearArea(SDL_Renderer * renderer, const SDL_Rect * area){
-    SDL_RenderFillRect(renderer, area);
-}
-
-// Draw the grid lines
-void drawGrid(SDL_Renderer * renderer, Simulation * sim){
-    int width, height, zoom;
-    int px, py;
-    int maxWidth, maxHeight;
-    SDL_Rect simulationAreaOnScreen = viewport(sim);
-    width = sim->size.width;
-    height  = sim->size.height;
-    px = 0;
-    py = 0;
-    zoom  = sim->zoom;
-    maxHeight  = (zoom * height ) + height;
-    maxWidth = (zoom * width) + width;
-    
-    setDrawColor(renderer, &color_white);
-    clearArea(renderer, &simulationAreaOnScreen);
-    setDrawColor(renderer, &color_black);
-    
-    for(int i = 0; i < width + 1; i++){
-        drawLineWithOffset(renderer, &sim->offset, px, 0, px, maxHeight);
-        px += zoom + 1;
-    }
-    for(int i = 0; i < height + 1; i++){
-        drawLineWithOffset(renderer, &sim->offset, 0, py, maxWidth, py);
-        py += zoom + 1;
-    }
-}
-
-// Draw the cell in the given row and column
-void drawCell(SDL_Renderer * renderer, Simulation * sim, int row, int column){
-    SDL_Rect area;
-    area.y = row * (sim->zoom + 1);
-    area.x = column * (sim->zoom + 1);
-    area.w = sim->zoom + 1;
-    area.h = sim->zoom + 1;
-    drawRectWithOffset(renderer, &sim->offset, &area);
-}
-
-// Iterate over all the cells and draw them
-void drawCells(SDL_Renderer * renderer, Simulation * sim){
-    int ** map = sim->map;
-    for(int r = 0; r < sim->size.height; r++){
-        for(int c = 0; c < sim->size.width; c++){
-            if(map[r][c]){
-                drawCell(renderer, sim, r, c);
-            }
-        }
-    }
-}
-
-// Draw a button
-void drawButton(SDL_Renderer * renderer, Button * button){
-    setDrawColor(renderer, &color_white);
-    SDL_RenderFillRect(renderer, &(button->area));
-    SDL_RenderDrawRect(renderer, &(button->area));
-    SDL_RenderCopy(renderer, button->label, NULL, &(button->labelPosition));
-}
-
-// Draw the "Speed:" label
-void drawSpeedLabel(SDL_Renderer * renderer){
-    SDL_RenderCopy(renderer, speedLabel, NULL, &speedLabelPosition);
-}
-
-// Draw the speed slider
-void drawSpeedChanger(SDL_Renderer * renderer, Simulation * sim){
-    char text[4] = {0};
-    SDL_Rect labelPosition;
-
-    SDL_Rect slider = (SDL_Rect){  0, 475,  20,  20};
-    slider.x = speedBar.x + (int)(((speedBar.w-slider.w) / (double)(50-1)) * (sim->speed - 1));
-    setDrawColor(renderer, &color_background);
-    SDL_RenderFillRect(renderer, &speedBar);
-    setDrawColor(renderer, &color_speed_indicator);
-    SDL_RenderFillRect(renderer, &slider);
-    
-    snprintf(text, 4, "%d", sim->speed);
-    SDL_Texture * label = initText(renderer, text, &color_white, &color_speed_indicator);
-    SDL_QueryTexture(label, NULL, NULL, &labelPosition.w, &labelPosition.h);
-    labelPosition.x = slider.x + ((slider.w - labelPosition.w) / 2);
-    labelPosition.y = slider.y + ((slider.h - labelPosition.h) / 2);
-    SDL_RenderCopy(renderer, label, NULL, &labelPosition);
-    SDL_DestroyTexture(label);
-}
-
-// Draw all the menu components
-// Components: Background color, Buttons, Texts, Speed Slider
-void drawMenu(SDL_Renderer * renderer, Simulation * sim, Button buttons[], int numOfButtons){
-    setDrawColor(renderer, &color_menu);
-    clearArea(renderer, &menu_area);
-    
-    for(int i = 0; i < numOfButtons; i++){
-        drawButton(renderer, &(buttons[i]));
-    }
-    
-    drawSpeedLabel(renderer);
-    drawSpeedChanger(renderer, sim);
-}
-
-// Renders the current frame
-void renderFrame(SDL_Renderer * renderer, Simulation * sim, Button buttons[], int numOfButtons){
-    clearWindow(renderer);
-    drawGrid(renderer, sim);
-    drawCells(renderer, sim);
-    drawMenu(renderer, sim, buttons, numOfButtons);
-    SDL_RenderPresent(renderer);
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "error.h"
+#include "draw.h"
+#include "text.h"
+
+// Texel of an active cell (black)
+#define CELL_TEXEL_ACTIVE 0xFF000000u
+
+// Texel of an inactive cell (transparent)
+#define CELL_TEXEL_EMPTY 0x00000000u
+
+// Grid lines are not drawn below this zoom level (they would cover most of the cells)
+#define GRID_MIN_ZOOM 3
+
+// Opacity of a block with a single active cell when zoomed out
+#define DENSITY_MIN_ALPHA 64
+
+// Texture of the visible cells
+static CellTexture cellTexture;
+
+// Texture of the population densities when zoomed out
+static DensityTexture densityTexture;
+
+// Areas of the window to be redrawn in the next frame
+static Damage damage = {.firstFrame = true};
+
+// Timing of the drawn frames
+static FrameStats frameStats;
+
+// Performance overlay on the menu
+static StatsOverlay statsOverlay;
+
+// Set the color of the next drawing operation
+void setDrawColor(SDL_Renderer * renderer, SDL_Color const * color){
+    SDL_SetRenderDrawColor(renderer, color->r, color->g, color->b, color->a);
+}
+
+// Division rounded towards negative infinity
+// Return: Quotient
+static int floorDiv(int a, int b){
+    return a >= 0 ? a / b : (a - b + 1) / b;
+}
+
+// Get the part of the window the map is drawn in (the window without the menu)
+// Return: SDL_Rect
+SDL_Rect mapScreenArea(){
+    return (SDL_Rect){0, 0, menu_area.x, menu_area.h};
+}
+
+// Get the area of the map on the screen
+// Return: SDL_Rect
+SDL_Rect viewport(Simulation * sim){
+    SDL_Rect area;
+    if(sim->universe != NULL){
+        // The unbounded plane covers the whole screen next to the menu
+        return mapScreenArea();
+    }
+    area.x = sim->offset.x;
+    area.y = sim->offset.y;
+    if(sim->zoom < 0){
+        // A pixel for every started block of cells
+        area.w = (sim->size.width + (1 << -sim->zoom) - 1) >> -sim->zoom;
+        area.h = (sim->size.height + (1 << -sim->zoom) - 1) >> -sim->zoom;
+        return area;
+    }
+    area.w = sim->size.width * (sim->zoom + 1);
+    area.h = sim->size.height  * (sim->zoom + 1);
+    return area;
+}
+
+// Get the blocks of cells the map area samples (the snapshots of the simulation copy only them)
+// (below zoom level 0 a pixel shows a block of 2^-zoom x 2^-zoom cells, otherwise a texel shows a cell)
+// Return: SDL_Rect of blocks
+SDL_Rect sampledBlocks(Simulation * sim){
+    SDL_Rect area = mapScreenArea();
+    int pitch = sim->zoom + 1;
+    if(sim->zoom < 0){
+        return (SDL_Rect){area.x - sim->offset.x, area.y - sim->offset.y, area.w, area.h};
+    }
+    // The same cells as the texture of the cells
+    return (SDL_Rect){floorDiv(area.x - sim->offset.x, pitch), floorDiv(area.y - sim->offset.y, pitch),
+                      area.w / pitch + 2, area.h / pitch + 2};
+}
+
+// Fill the screen with color_background
+void clearWindow(SDL_Renderer * renderer){
+    setDrawColor(renderer, &color_background);
+    SDL_RenderClear(renderer);
+}
+
+// Clear given area of the screen
+void clearArea(SDL_Renderer * renderer, const SDL_Rect * area){
+    SDL_RenderFillRect(renderer, area);
+}
+
+// Draw the background of the map and the grid lines inside the given area of the screen
+// (below GRID_MIN_ZOOM only the background of the map is drawn)
+void drawGrid(SDL_Renderer * renderer, Simulation * sim, const SDL_Rect * area){
+    int pitch = sim->zoom + 1;
+    int first, last;
+    SDL_Rect mapArea = mapScreenArea();
+    SDL_Rect map = viewport(sim);
+    SDL_Rect screen, visible, lines;
+    
+    if(!SDL_IntersectRect(&mapArea, area, &screen) || !SDL_IntersectRect(&map, &screen, &visible)){
+        return;
+    }
+    setDrawColor(renderer, &color_white);
+    clearArea(renderer, &visible);
+    if(sim->zoom < GRID_MIN_ZOOM){
+        return;
+    }
+    setDrawColor(renderer, &color_black);
+    
+    // The last line of the map is right after the area of the map
+    if(sim->universe == NULL){
+        map.w++;
+        map.h++;
+    }
+    if(!SDL_IntersectRect(&map, &screen, &lines)){
+        return;
+    }
+    // Vertical lines are at offset.x + i * pitch
+    first = -floorDiv(sim->offset.x - lines.x, pitch);
+    last = floorDiv(lines.x + lines.w - 1 - sim->offset.x, pitch);
+    for(int i = first; i <= last; i++){
+        SDL_RenderDrawLine(renderer, sim->offset.x + i * pitch, lines.y, sim->offset.x + i * pitch, lines.y + lines.h - 1);
+    }
+    // Horizontal lines are at offset.y + i * pitch
+    first = -floorDiv(sim->offset.y - lines.y, pitch);
+    last = floorDiv(lines.y + lines.h - 1 - sim->offset.y, pitch);
+    for(int i = first; i <= last; i++){
+        SDL_RenderDrawLine(renderer, lines.x, sim->offset.y + i * pitch, lines.x + lines.w - 1, sim->offset.y + i * pitch);
+    }
+}
+
+// Get a word of a row of the snapshot (bit i is the cell in column w*64+i)
+// Return: The word, or 0 if it is outside of the map
+static uint64_t snapshotWord(const Snapshot * snapshot, int w, int y){
+    const Tile * tile;
+    if(snapshot->universe != NULL){
+        tile = findTile(snapshot->universe, w, y >> 6);
+        return tile == NULL ? 0 : tile->cells[y & 63];
+    }
+    // Only the region of the view was copied to the snapshot
+    if(w < snapshot->region.x || w >= snapshot->region.x + snapshot->region.w ||
+       y < snapshot->region.y || y >= snapshot->region.y + snapshot->region.h){
+        return 0;
+    }
+    return mapRow(&snapshot->map, y)[w];
+}
+
+// Get 64 cells of a row starting at the given column
+// Return: The cells (bit i is the cell in column x+i)
+static uint64_t snapshotBits(const Snapshot * snapshot, int x, int y){
+    int w = x >> 6;
+    int shift = x & 63;
+    uint64_t bits = snapshotWord(snapshot, w, y) >> shift;
+    if(shift != 0){
+        bits |= snapshotWord(snapshot, w + 1, y) << (WORD_BITS - shift);
+    }
+    return bits;
+}
+
+// Frees the texture of the cells
+static void celltexture_free(){
+    CellTexture * ct = &cellTexture;
+    if(ct->texture != NULL){
+        SDL_DestroyTexture(ct->texture);
+    }
+    free(ct->cells);
+    free(ct->pixels);
+    *ct = (CellTexture){0};
+}
+
+// Resize the texture to the given number of cells (it is recreated only if the size changed)
+static void resizeCellTexture(SDL_Renderer * renderer, int columns, int rows){
+    CellTexture * ct = &cellTexture;
+    if(ct->texture != NULL && ct->columns == columns && ct->rows == rows){
+        return;
+    }
+    celltexture_free();
+    // Cells are scaled up with nearest-neighbour sampling, so they keep sharp edges
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+    ct->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, columns, rows);
+    if(ct->texture == NULL){
+        printf("SDL_CreateTexture: %s\n", SDL_GetError());
+        return;
+    }
+    // Inactive cells are transparent, so the grid lines under them stay visible
+    SDL_SetTextureBlendMode(ct->texture, SDL_BLENDMODE_BLEND);
+    ct->columns = columns;
+    ct->rows = rows;
+    ct->words = (columns + WORD_BITS - 1) / WORD_BITS;
+    ct->cells = malloc((size_t)ct->words * rows * sizeof(uint64_t));
+    ct->pixels = malloc((size_t)columns * rows * sizeof(Uint32));
+    if(ct->cells == NULL || ct->pixels == NULL){
+        notEnoughMemory();
+    }
+    ct->valid = false;
+}
+
+// Upload the rows [first, last) of the cached cells to the texture
+static void uploadCellRows(int first, int last){
+    CellTexture * ct = &cellTexture;
+    SDL_Rect area = (SDL_Rect){0, first, ct->columns, last - first};
+    Uint32 * pixels = ct->pixels;
+    const uint64_t * row;
+    for(int r = first; r < last; r++){
+        row = &ct->cells[(size_t)r * ct->words];
+        for(int c = 0; c < ct->columns; c++){
+            *pixels++ = ((row[c >> 6] >> (c & 63)) & 0x1) ? CELL_TEXEL_ACTIVE : CELL_TEXEL_EMPTY;
+        }
+    }
+    SDL_UpdateTexture(ct->texture, &area, ct->pixels, ct->columns * sizeof(Uint32));
+}
+
+// Copy the visible cells of the snapshot to the texture, only the rows that changed are uploaded
+void updateCellTexture(SDL_Renderer * renderer, Simulation * sim, const Snapshot * snapshot){
+    CellTexture * ct = &cellTexture;
+    SDL_Rect area = mapScreenArea();
+    int pitch = sim->zoom + 1;
+    int originX, originY, dirtyFirst = -1;
+    int firstWord = 0, lastWord = 0;
+    uint64_t bits, * row;
+    bool rowChanged;
+    
+    // One texel for every cell that is at least partially on the screen
+    resizeCellTexture(renderer, area.w / pitch + 2, area.h / pitch + 2);
+    if(ct->texture == NULL){
+        return;
+    }
+    originX = floorDiv(area.x - sim->offset.x, pitch);
+    originY = floorDiv(area.y - sim->offset.y, pitch);
+    if(originX != ct->originX || originY != ct->originY){
+        // The view moved by at least a cell, every row has to be uploaded
+        ct->originX = originX;
+        ct->originY = originY;
+        ct->valid = false;
+    }
+    for(int r = 0; r <= ct->rows; r++){
+        rowChanged = false;
+        if(r < ct->rows){
+            row = &ct->cells[(size_t)r * ct->words];
+            for(int w = 0; w < ct->words; w++){
+                bits = snapshotBits(snapshot, originX + w * WORD_BITS, originY + r);
+                if(!ct->valid || bits != row[w]){
+                    row[w] = bits;
+                    // The changed words of a run of rows
+                    if(!rowChanged && dirtyFirst < 0){
+                        firstWord = lastWord = w;
+                    }
+                    firstWord = w < firstWord ? w : firstWord;
+                    lastWord = w > lastWord ? w : lastWord;
+                    rowChanged = true;
+                }
+            }
+        }
+        // Consecutive changed rows are uploaded at once, and their area on the screen is redrawn
+        if(rowChanged && dirtyFirst < 0){
+            dirtyFirst = r;
+        } else if(!rowChanged && dirtyFirst >= 0){
+            uploadCellRows(dirtyFirst, r);
+            markDirtyArea(&(SDL_Rect){sim->offset.x + (originX + firstWord * WORD_BITS) * pitch,
+                                      sim->offset.y + (originY + dirtyFirst) * pitch,
+                                      (lastWord - firstWord + 1) * WORD_BITS * pitch,
+                                      (r - dirtyFirst) * pitch});
+            dirtyFirst = -1;
+        }
+    }
+    ct->valid = true;
+}
+
+// Frees the texture of the population densities
+static void densitytexture_free(){
+    DensityTexture * dt = &densityTexture;
+    if(dt->texture != NULL){
+        SDL_DestroyTexture(dt->texture);
+    }
+    free(dt->counts);
+    *dt = (DensityTexture){0};
+}
+
+// Add the active cells of the visible tiles of the unbounded plane to the blocks of the pixels
+static void countUniverseBlocks(Simulation * sim, const Universe * u, int width, int height){
+    DensityTexture * dt = &densityTexture;
+    int shift = -sim->zoom;
+    int blockSize = 1 << shift;
+    int px, py, tilePixels;
+    uint64_t mask = blockSize >= WORD_BITS ? ~(uint64_t)0 : ((uint64_t)1 << blockSize) - 1;
+    const Tile * tile;
+    
+    tilePixels = (UNIVERSE_TILE_SIZE + blockSize - 1) >> shift;
+    for(int i = 0; i < u->numOfTiles; i++){
+        tile = u->tiles[i];
+        px = ((tile->x * UNIVERSE_TILE_SIZE) >> shift) + sim->offset.x;
+        py = ((tile->y * UNIVERSE_TILE_SIZE) >> shift) + sim->offset.y;
+        if(px >= width || py >= height || px + tilePixels <= 0 || py + tilePixels <= 0){
+            continue;
+        }
+        if(blockSize >= UNIVERSE_TILE_SIZE){
+            // The whole tile is in one block
+            dt->counts[(size_t)py * width + px] += tile->stats.population;
+            continue;
+        }
+        for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+            if(tile->cells[r] == 0 || py + (r >> shift) < 0 || py + (r >> shift) >= height){
+                continue;
+            }
+            for(int c = 0; c < tilePixels; c++){
+                if(px + c >= 0 && px + c < width){
+                    dt->counts[(size_t)(py + (r >> shift)) * width + px + c] +=
+                        __builtin_popcountll((tile->cells[r] >> (c << shift)) & mask);
+                }
+            }
+        }
+    }
+}
+
+// Calculate the population density of the block of cells shown by every pixel of the map area
+// (used below zoom level 0, the cost depends on the number of pixels, not on the number of cells)
+void updateDensityTexture(SDL_Renderer * renderer, Simulation * sim, const Snapshot * snapshot){
+    DensityTexture * dt = &densityTexture;
+    SDL_Rect area = mapScreenArea();
+    int shift = -sim->zoom;
+    uint64_t cellsPerPixel = (uint64_t)1 << (2 * shift);
+    uint32_t count;
+    Uint32 * pixels;
+    int pitch;
+    
+    if(dt->texture == NULL || dt->width != area.w || dt->height != area.h){
+        densitytexture_free();
+        dt->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, area.w, area.h);
+        if(dt->texture == NULL){
+            printf("SDL_CreateTexture: %s\n", SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(dt->texture, SDL_BLENDMODE_BLEND);
+        dt->width = area.w;
+        dt->height = area.h;
+        dt->counts = malloc((size_t)area.w * area.h * sizeof(uint32_t));
+        if(dt->counts == NULL){
+            notEnoughMemory();
+        }
+    }
+    
+    // Population of the block shown by each pixel
+    if(snapshot->universe != NULL){
+        memset(dt->counts, 0, (size_t)area.w * area.h * sizeof(uint32_t));
+        countUniverseBlocks(sim, snapshot->universe, area.w, area.h);
+    } else if(snapshot->hasPyramid || shift < PYRAMID_FIRST_LEVEL){
+        for(int py = 0; py < area.h; py++){
+            for(int px = 0; px < area.w; px++){
+                dt->counts[(size_t)py * area.w + px] = blockPopulation(&snapshot->pyramid, &snapshot->map, shift,
+                                                                       px - sim->offset.x, py - sim->offset.y);
+            }
+        }
+    } else {
+        return;
+    }
+    
+    if(SDL_LockTexture(dt->texture, NULL, (void**)&pixels, &pitch) != 0){
+        return;
+    }
+    for(int py = 0; py < area.h; py++){
+        for(int px = 0; px < area.w; px++){
+            count = dt->counts[(size_t)py * area.w + px];
+            // Black with an opacity that grows with the density, a single cell is still visible
+            pixels[px] = count == 0 ? CELL_TEXEL_EMPTY :
+                         (Uint32)(DENSITY_MIN_ALPHA + (255 - DENSITY_MIN_ALPHA) * count / cellsPerPixel) << 24;
+        }
+        pixels = (Uint32*)((Uint8*)pixels + pitch);
+    }
+    SDL_UnlockTexture(dt->texture);
+    markDirtyArea(&area);
+}
+
+// Draw the texture of the cells scaled to the zoom level
+// (below zoom level 0 the texture of the population densities is drawn)
+void drawCells(SDL_Renderer * renderer, Simulation * sim){
+    CellTexture * ct = &cellTexture;
+    int pitch = sim->zoom + 1;
+    SDL_Rect area;
+    if(sim->zoom < 0){
+        if(densityTexture.texture != NULL){
+            area = mapScreenArea();
+            SDL_RenderCopy(renderer, densityTexture.texture, NULL, &area);
+        }
+        return;
+    }
+    if(ct->texture == NULL){
+        return;
+    }
+    area.x = sim->offset.x + ct->originX * pitch;
+    area.y = sim->offset.y + ct->originY * pitch;
+    area.w = ct->columns * pitch;
+    area.h = ct->rows * pitch;
+    SDL_RenderCopy(renderer, ct->texture, NULL, &area);
+}
+
+// Draw a button
+void drawButton(SDL_Renderer * renderer, Button * button){
+    setDrawColor(renderer, &color_white);
+    SDL_RenderFillRect(renderer, &(button->area));
+    SDL_RenderDrawRect(renderer, &(button->area));
+    SDL_RenderCopy(renderer, button->label, NULL, &(button->labelPosition));
+}
+
+// Draw the "Speed:" label
+void drawSpeedLabel(SDL_Renderer * renderer){
+    SDL_RenderCopy(renderer, speedLabel, NULL, &speedLabelPosition);
+}
+
+// Draw the speed slider
+void drawSpeedChanger(SDL_Renderer * renderer, Simulation * sim){
+    char text[24] = {0};
+    SDL_Rect labelPosition;
+
+    SDL_Rect slider = (SDL_Rect){  0, speedBar.y, SPEED_KNOB_SIZE, SPEED_KNOB_SIZE};
+    slider.x = speedBar.x + (int)((speedBar.w - slider.w) * speedSliderPosition(sim->speed));
+    setDrawColor(renderer, &color_background);
+    SDL_RenderFillRect(renderer, &speedBar);
+    setDrawColor(renderer, &color_speed_indicator);
+    SDL_RenderFillRect(renderer, &slider);
+    
+    // The speed is written after the "Speed:" label (the knob is too small for the larger numbers)
+    // The texture of the text is reused from the cache, no text is rendered while the speed stays the same
+    if(sim->speed == SPEED_UNLIMITED){
+        snprintf(text, sizeof(text), "unlimited");
+    } else {
+        snprintf(text, sizeof(text), "%d gen/s", sim->speed);
+    }
+    SDL_Texture * label = cachedText(renderer, text, &color_white, &color_menu, &labelPosition.w, &labelPosition.h);
+    if(label == NULL){
+        return;
+    }
+    labelPosition.x = speedLabelPosition.x + speedLabelPosition.w;
+    labelPosition.y = speedLabelPosition.y;
+    SDL_RenderCopy(renderer, label, NULL, &labelPosition);
+}
+
+// Draw all the menu components
+// Components: Background color, Buttons, Texts, Speed Slider
+void drawMenu(SDL_Renderer * renderer, Simulation * sim, Button buttons[], int numOfButtons){
+    setDrawColor(renderer, &color_menu);
+    clearArea(renderer, &menu_area);
+    
+    for(int i = 0; i < numOfButtons; i++){
+        drawButton(renderer, &(buttons[i]));
+    }
+    
+    drawSpeedLabel(renderer);
+    drawSpeedChanger(renderer, sim);
+    drawStatsOverlay(renderer);
+}
+
+// Draw the performance overlay (if it is shown)
+void drawStatsOverlay(SDL_Renderer * renderer){
+    SDL_Rect position;
+    if(!statsOverlay.visible){
+        return;
+    }
+    for(int i = 0; i < STATS_LINES; i++){
+        SDL_Texture * label = cachedText(renderer, statsOverlay.lines[i], &color_white, &color_menu, &position.w, &position.h);
+        if(label == NULL){
+            continue;
+        }
+        position.x = statsArea.x;
+        position.y = statsArea.y + i * STATS_LINE_HEIGHT;
+        SDL_RenderCopy(renderer, label, NULL, &position);
+    }
+}
+
+// Show or hide the performance overlay
+void toggleStatsOverlay(){
+    statsOverlay.visible = !statsOverlay.visible;
+    // The counters are measured from now on
+    statsOverlay.lastUpdate = 0;
+    markDirtyArea(&statsArea);
+}
+
+// Update the texts of the performance overlay if they are older than STATS_UPDATE_INTERVAL
+// (the rates and the averages are measured since the previous update)
+static void updateStatsOverlay(const Snapshot * snapshot){
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Stats * stats = &snapshot->stats;
+    double seconds;
+    char (*lines)[MAX_CACHED_TEXT] = statsOverlay.lines;
+    
+    if(!statsOverlay.visible){
+        return;
+    }
+    if(statsOverlay.lastUpdate != 0 && (now - statsOverlay.lastUpdate) * 1000 < STATS_UPDATE_INTERVAL * frequency){
+        return;
+    }
+    if(statsOverlay.lastUpdate == 0){
+        // First update: there is nothing to measure the rates from
+        statsOverlay.previous = *stats;
+        statsOverlay.previousFrames = frameStats;
+        seconds = 0;
+    } else {
+        seconds = (double)(now - statsOverlay.lastUpdate) / frequency;
+    }
+    snprintf(lines[0], MAX_CACHED_TEXT, "Gen/s: %.1f Tiles: %d",
+             seconds > 0 ? (stats->generations - statsOverlay.previous.generations) / seconds : 0.0,
+             snapshot->cells.calculatedTiles);
+    snprintf(lines[1], MAX_CACHED_TEXT, "Pop: %lld +%lld -%lld",
+             snapshot->cells.population, snapshot->cells.births, snapshot->cells.deaths);
+    snprintf(lines[2], MAX_CACHED_TEXT, "Memory: %.1f MB", snapshot->memory / (1024.0 * 1024.0));
+    snprintf(lines[3], MAX_CACHED_TEXT, "Step %.3f I/O %.1f ms",
+             averageTime(&stats->step, &statsOverlay.previous.step), stats->io.last * 1000);
+    snprintf(lines[4], MAX_CACHED_TEXT, "Draw %.2f Present %.2f ms",
+             averageTime(&frameStats.render, &statsOverlay.previousFrames.render),
+             averageTime(&frameStats.present, &statsOverlay.previousFrames.present));
+    snprintf(lines[5], MAX_CACHED_TEXT, "Frame %.1f/%.1f/%.1f ms",
+             frameTimePercentile(&frameStats, 50), frameTimePercentile(&frameStats, 95), frameTimePercentile(&frameStats, 99));
+    statsOverlay.previous = *stats;
+    statsOverlay.previousFrames = frameStats;
+    statsOverlay.lastUpdate = now;
+    markDirtyArea(&statsArea);
+}
+
+// Get the area of the whole window
+// Return: SDL_Rect
+static SDL_Rect windowArea(){
+    return (SDL_Rect){0, 0, menu_area.x + menu_area.w, menu_area.h};
+}
+
+// Mark an area of the window to be redrawn in the next frame
+void markDirtyArea(const SDL_Rect * area){
+    SDL_Rect window = windowArea();
+    SDL_Rect dirty, merged;
+    if(!SDL_IntersectRect(area, &window, &dirty)){
+        return;
+    }
+    // Overlapping areas are merged
+    for(int i = 0; i < damage.numOfRects; i++){
+        if(SDL_HasIntersection(&damage.rects[i], &dirty)){
+            SDL_UnionRect(&damage.rects[i], &dirty, &merged);
+            damage.rects[i] = damage.rects[--damage.numOfRects];
+            markDirtyArea(&merged);
+            return;
+        }
+    }
+    if(damage.numOfRects == MAX_DIRTY_RECTS){
+        // Too many areas, the last one grows to cover the new one
+        SDL_UnionRect(&damage.rects[damage.numOfRects - 1], &dirty, &damage.rects[damage.numOfRects - 1]);
+        return;
+    }
+    damage.rects[damage.numOfRects++] = dirty;
+}
+
+// Mark the areas that changed because the view, the size of the map or the speed changed
+static void trackViewChanges(Simulation * sim, const Snapshot * snapshot){
+    if(sim->offset.x != damage.offset.x || sim->offset.y != damage.offset.y || sim->zoom != damage.zoom ||
+       snapshot->map.width != damage.mapWidth || snapshot->map.height != damage.mapHeight){
+        // Pan, zoom or a new map: everything moved
+        markDirtyArea(&(SDL_Rect){0, 0, menu_area.x, menu_area.h});
+        damage.offset = sim->offset;
+        damage.zoom = sim->zoom;
+        damage.mapWidth = snapshot->map.width;
+        damage.mapHeight = snapshot->map.height;
+    }
+    if(sim->speed != damage.speed){
+        // The slider and the speed written above it
+        markDirtyArea(&(SDL_Rect){speedBar.x, speedLabelPosition.y, speedBar.w, speedBar.y + speedBar.h - speedLabelPosition.y});
+        damage.speed = sim->speed;
+    }
+}
+
+// Redraw an area of the window (the drawing is clipped to the area)
+static void redrawArea(SDL_Renderer * renderer, Simulation * sim, Button buttons[], int numOfButtons, const SDL_Rect * area){
+    SDL_Rect mapArea = mapScreenArea();
+    SDL_RenderSetClipRect(renderer, area);
+    setDrawColor(renderer, &color_background);
+    clearArea(renderer, area);
+    if(SDL_HasIntersection(area, &mapArea)){
+        drawGrid(renderer, sim, area);
+        drawCells(renderer, sim);
+    }
+    if(SDL_HasIntersection(area, &menu_area)){
+        drawMenu(renderer, sim, buttons, numOfButtons);
+    }
+    SDL_RenderSetClipRect(renderer, NULL);
+}
+
+// Create the back buffer that keeps the content of the window between frames
+// Return: TRUE if the back buffer exists, FALSE if the renderer can't draw to textures
+static bool createBackBuffer(SDL_Renderer * renderer){
+    SDL_Rect window = windowArea();
+    if(damage.backBuffer != NULL){
+        return true;
+    }
+    damage.backBuffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, window.w, window.h);
+    if(damage.backBuffer == NULL){
+        return false;
+    }
+    markDirtyArea(&window);
+    return true;
+}
+
+// Frees the textures of the renderer
+void draw_free(){
+    celltexture_free();
+    densitytexture_free();
+    if(damage.backBuffer != NULL){
+        SDL_DestroyTexture(damage.backBuffer);
+    }
+    damage = (Damage){0};
+    damage.firstFrame = true;
+    frameStats = (FrameStats){0};
+    statsOverlay = (StatsOverlay){0};
+}
+
+// Renders the current frame
+// Only the areas that changed since the last frame (cells, pan and zoom, slider) are redrawn
+// on the back buffer, then the back buffer is copied to the window.
+// (the cells are drawn from the snapshot, the view and the menu from the simulation)
+void renderFrame(SDL_Renderer * renderer, Simulation * sim, const Snapshot * snapshot, Button buttons[], int numOfButtons){
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 presentStart;
+    double frameTime;
+    SDL_Rect window = windowArea();
+    if(damage.firstFrame){
+        markDirtyArea(&window);
+        damage.firstFrame = false;
+    }
+    trackViewChanges(sim, snapshot);
+    updateStatsOverlay(snapshot);
+    if(sim->zoom < 0){
+        updateDensityTexture(renderer, sim, snapshot);
+    } else {
+        updateCellTexture(renderer, sim, snapshot);
+    }
+    
+    if(!createBackBuffer(renderer)){
+        // Without a back buffer the whole window is drawn
+        redrawArea(renderer, sim, buttons, numOfButtons, &window);
+    } else {
+        SDL_SetRenderTarget(renderer, damage.backBuffer);
+        for(int i = 0; i < damage.numOfRects; i++){
+            redrawArea(renderer, sim, buttons, numOfButtons, &damage.rects[i]);
+        }
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_RenderCopy(renderer, damage.backBuffer, NULL, NULL);
+    }
+    damage.numOfRects = 0;
+    frameTime = stopTimer(&frameStats.render, start);
+    presentStart = SDL_GetPerformanceCounter();
+    SDL_RenderPresent(renderer);
+    frameTime += stopTimer(&frameStats.present, presentStart);
+    recordFrameTime(&frameStats, frameTime);
 }
\ No newline at end of file
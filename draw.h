@@ -1,52 +1,136 @@
-#ifndef DRAW_H
-#define DRAW_H
-
-#include <SDL2/SDL.h>
-#include "simulation.h"
-#include "userInterface.h"
-
-// Set the color of the next drawing operation
-void setDrawColor(SDL_Renderer * renderer, SDL_Color const * color);
-
-// Draw a line between the two points with the given offset
-void drawLineWithOffset(SDL_Renderer * renderer, Offset * offset, int x1, int y1, int x2, int y2);
-
-// Draw a rectangle with offset
-void drawRectWithOffset(SDL_Renderer * renderer, Offset * offset, SDL_Rect * area);
-
-// Get the area of the map on the screen
-// Return: SDL_Rect
-SDL_Rect viewport(Simulation * sim);
-
-// Fill the screen with color_background
-void clearWindow(SDL_Renderer * renderer);
-
-// Clear given area of the screen
-void clearArea(SDL_Renderer * renderer, const SDL_Rect * area);
-
-// Draw the grid lines
-void drawGrid(SDL_Renderer * renderer, Simulation * sim);
-
-// Draw the cell in the given row and column
-void drawCell(SDL_Renderer * renderer, Simulation * sim, int row, int column);
-
-// Iterate over all the cells and draw them
-void drawCells(SDL_Renderer * renderer, Simulation * sim);
-
-// Draw a button
-void drawButton(SDL_Renderer * renderer, Button * button);
-
-// Draw the "Speed:" label
-void drawSpeedLabel(SDL_Renderer * renderer);
-
-// Draw the speed slider
-void drawSpeedChanger(SDL_Renderer * renderer, Simulation * sim);
-
-// Draw all the menu components
-// Components: Background color, Buttons, Texts, Speed Slider
-void drawMenu(SDL_Renderer * renderer, Simulation * sim, Button buttons[], int numOfButtons);
-
-// Renders the current frame
-void renderFrame(SDL_Renderer * renderer, Simulation * sim, Button buttons[], int numOfButtons);
-
+#ifndef DRAW_H
+#define DRAW_H
+
+#include <SDL2/SDL.h>
+#include "simulation.h"
+#include "userInterface.h"
+#include "simulationThread.h"
+#include "text.h"
+#include "stats.h"
+
+// Streaming texture of the cells that are on the screen (one texel per cell)
+typedef struct CellTexture{
+    SDL_Texture * texture; // Texture of the cells (NULL if it is not created yet)
+    int columns;           // Number of cells in a row of the texture
+    int rows;              // Number of rows of the texture
+    int originX;           // Position of the cell in the top left texel
+    int originY;
+    int words;             // Number of words in a row of the cached cells
+    uint64_t * cells;      // Cells currently in the texture (to find the rows that changed)
+    Uint32 * pixels;       // Buffer of the texels uploaded to the texture
+    bool valid;            // The cached cells are the content of the texture
+} CellTexture;
+
+// Streaming texture of the population densities when zoomed out (one texel per pixel)
+typedef struct DensityTexture{
+    SDL_Texture * texture; // Texture of the map area (NULL if it is not created yet)
+    int width;             // Size of the texture in pixels
+    int height;
+    uint32_t * counts;     // Number of active cells in the block of each pixel
+} DensityTexture;
+
+// Number of text lines of the performance overlay
+#define STATS_LINES 6
+
+// Height of a line of the performance overlay (in pixels)
+#define STATS_LINE_HEIGHT 15
+
+// Time between two updates of the performance overlay (in milliseconds)
+#define STATS_UPDATE_INTERVAL 500
+
+// Performance overlay on the menu
+// The texts are updated twice a second, so their cached textures are reused between the updates.
+typedef struct StatsOverlay{
+    bool visible;                  // The overlay is shown
+    Uint64 lastUpdate;             // Time of the last update of the texts (0: never)
+    Stats previous;                // Counters of the simulation at the last update
+    FrameStats previousFrames;     // Frame timings at the last update
+    char lines[STATS_LINES][MAX_CACHED_TEXT]; // Texts of the overlay
+} StatsOverlay;
+
+// Maximum number of dirty rectangles in a frame
+#define MAX_DIRTY_RECTS 16
+
+// Areas of the window that changed since the last frame
+typedef struct Damage{
+    SDL_Rect rects[MAX_DIRTY_RECTS]; // Areas to be redrawn (overlapping areas are merged)
+    int numOfRects;                  // Number of areas
+    SDL_Texture * backBuffer;        // Content of the window kept between frames (NULL if it is not created yet)
+    bool firstFrame;                 // Nothing was drawn yet
+    Offset offset;                   // View of the last frame (a change redraws the whole map area)
+    int zoom;
+    int mapWidth;                    // Size of the map in the last frame
+    int mapHeight;
+    int speed;                       // Speed on the slider in the last frame
+} Damage;
+
+// Set the color of the next drawing operation
+void setDrawColor(SDL_Renderer * renderer, SDL_Color const * color);
+
+// Get the part of the window the map is drawn in (the window without the menu)
+// Return: SDL_Rect
+SDL_Rect mapScreenArea();
+
+// Get the area of the map on the screen
+// Return: SDL_Rect
+SDL_Rect viewport(Simulation * sim);
+
+// Get the blocks of cells the map area samples (the snapshots of the simulation copy only them)
+// (below zoom level 0 a pixel shows a block of 2^-zoom x 2^-zoom cells, otherwise a texel shows a cell)
+// Return: SDL_Rect of blocks
+SDL_Rect sampledBlocks(Simulation * sim);
+
+// Fill the screen with color_background
+void clearWindow(SDL_Renderer * renderer);
+
+// Clear given area of the screen
+void clearArea(SDL_Renderer * renderer, const SDL_Rect * area);
+
+// Draw the background of the map and the grid lines inside the given area of the screen
+// (below GRID_MIN_ZOOM only the background of the map is drawn)
+void drawGrid(SDL_Renderer * renderer, Simulation * sim, const SDL_Rect * area);
+
+// Copy the visible cells of the snapshot to the texture, only the rows that changed are uploaded
+void updateCellTexture(SDL_Renderer * renderer, Simulation * sim, const Snapshot * snapshot);
+
+// Calculate the population density of the block of cells shown by every pixel of the map area
+// (used below zoom level 0, the cost depends on the number of pixels, not on the number of cells)
+void updateDensityTexture(SDL_Renderer * renderer, Simulation * sim, const Snapshot * snapshot);
+
+// Draw the texture of the cells scaled to the zoom level
+// (below zoom level 0 the texture of the population densities is drawn)
+void drawCells(SDL_Renderer * renderer, Simulation * sim);
+
+// Draw a button
+void drawButton(SDL_Renderer * renderer, Button * button);
+
+// Draw the "Speed:" label
+void drawSpeedLabel(SDL_Renderer * renderer);
+
+// Draw the speed slider
+void drawSpeedChanger(SDL_Renderer * renderer, Simulation * sim);
+
+// Draw all the menu components
+// Components: Background color, Buttons, Texts, Speed Slider
+void drawMenu(SDL_Renderer * renderer, Simulation * sim, Button buttons[], int numOfButtons);
+
+// Draw the performance overlay (if it is shown)
+void drawStatsOverlay(SDL_Renderer * renderer);
+
+// Show or hide the performance overlay
+void toggleStatsOverlay();
+
+// Mark an area of the window to be redrawn in the next frame
+void markDirtyArea(const SDL_Rect * area);
+
+// Frees the textures of the renderer
+void draw_free();
+
+// Renders the current frame
+// Only the areas that changed since the last frame (cells, pan and zoom, slider, overlay) are redrawn
+// on the back buffer, then the back buffer is copied to the window.
+// (the cells are drawn from the snapshot, the view and the menu from the simulation)
+// The time of drawing and presenting the frame is recorded for the performance overlay.
+void renderFrame(SDL_Renderer * renderer, Simulation * sim, const Snapshot * snapshot, Button buttons[], int numOfButtons);
+
 #endif
\ No newline at end of file
@@ -1,8 +1,8 @@
-#ifndef ERROR_H
-#define ERROR_H
-
-// After a failed attempt to allocate memory,
-// print error message and exit the program
-void notEnoughMemory();
-
+#ifndef ERROR_H
+#define ERROR_H
+
+// After a failed attempt to allocate memory,
+// print error message and exit the program
+void notEnoughMemory();
+
 #endif
\ No newline at end of file
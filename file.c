@@ -1,70 +1,953 @@
-#include <stdio.h>
-#include "file.h"
-
-// Save the current state of the simulation
-void saveSimulationToFile(Simulation * sim){
-    FILE * fp = fopen("map.bin", "wb");
-    unsigned char bitEncodedField;
-    unsigned char bitCounter;
-    
-    fprintf(fp, "%dx%d\n", sim->size.width, sim->size.height);
-    fprintf(fp, "%d\n", sim->speed);
-    for(int i = 0; i < sim->size.height; i++){
-        bitEncodedField = 0x00;
-        bitCounter = 0;
-        for(int j = 0; j < sim->size.width; j++){
-            if(sim->map[i][j] == 1){
-                bitEncodedField |= (0x1 << bitCounter);
-            }
-            bitCounter++;
-            if(bitCounter > 7){
-                fputc(bitEncodedField, fp);
-                bitEncodedField = 0x00;
-                bitCounter = 0;
-            }
-        }
-        if(bitCounter != 7){
-            fputc(bitEncodedField, fp);
-        }
-        fprintf(fp, "\n");
-    }
-    fclose(fp);
-}
-
-// Load simulation from file
-void loadSimulationFromFile(Simulation * sim, SDL_TimerID * timer){
-    FILE * fp = fopen("map.bin", "rb");
-    unsigned char bitEncodedField;
-    int width, height, speed;
-    unsigned char bit;
-    
-    if(fp == NULL){
-        printf("Error when loading map.\n(map.bin doesn't exist)\n");
-        return;
-    }
-    
-    fscanf(fp, "%dx%d\n", &width, &height);
-    fscanf(fp, "%d\n", &speed);
-    
-    simulation_reinit(sim, timer, width, height);
-    sim->speed = speed;
-    
-    for(int i = 0; i < height; i++){
-        bit = 0;
-        for(int j = 0; j < width; j++){
-            if(bit == 0){
-                bitEncodedField = fgetc(fp);
-            }
-            sim->map[i][j] = ((bitEncodedField >> bit) & 0x1);
-            bit++;
-            if(bit == 8){
-                bit = 0;
-            }
-        }
-        fgetc(fp); // Skip new line character
-    }
-    
-    setAsDefaultMap(sim);
-    
-    fclose(fp);
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "file.h"
+#include "error.h"
+
+// Size of the stdio buffer of the map files
+#define FILE_BUFFER_SIZE (1 << 20)
+
+// First bytes of a tiled map file
+#define TILED_MAGIC "GOLTILES"
+
+// Size of the magic bytes
+#define TILED_MAGIC_SIZE 8
+
+// Version of the tiled map format written by this program
+// (version 1 files have no rule, they are loaded with Conway's rule)
+#define TILED_VERSION 2
+
+// Size of the header of a tiled map file (in bytes)
+#define TILED_HEADER_SIZE 48
+
+// Size of an entry of the tile index (in bytes)
+#define TILED_ENTRY_SIZE 20
+
+// First bytes of a page-aligned map file
+#define PAGED_MAGIC "GOLPAGES"
+
+// Version of the page-aligned map format written by this program
+// (version 1 files have no rule, they are loaded with Conway's rule)
+#define PAGED_VERSION 2
+
+// Written as a native integer, the loader checks that the byte order is the same
+#define PAGED_BYTE_ORDER 0x0102030405060708ULL
+
+// Size of the uncompressed content of a tile (64 rows of 8 bytes)
+#define TILE_BYTES (UNIVERSE_TILE_SIZE * 8)
+
+// Largest compressed tile (a literal run header for every 128 bytes)
+#define MAX_PACKED_TILE (TILE_BYTES + TILE_BYTES / 128)
+
+// Header of a tiled map file (stored in little-endian byte order)
+typedef struct TiledHeader{
+    int width;            // Dimensions of the map (the bounding box of the cells on the unbounded plane)
+    int height;
+    int originX;          // Position of the top left cell of the map on the plane
+    int originY;
+    int speed;            // Speed of the simulation
+    uint32_t numOfTiles;  // Number of entries in the tile index
+    uint32_t rule;        // Rule of the simulation (see encodeRule())
+    uint64_t indexOffset; // Position of the tile index in the file
+} TiledHeader;
+
+// Entry of the tile index
+// Only the tiles that have active cells are stored
+typedef struct TileEntry{
+    int x;              // Column of the tile on the plane (cells x*64 ... x*64+63)
+    int y;              // Row of the tile on the plane
+    uint64_t offset;    // Position of the compressed tile in the file
+    uint32_t size;      // Size of the compressed tile (in bytes)
+} TileEntry;
+
+// Header page of a page-aligned map file
+// The header page is followed by the buffer of the map in memory order (see mapBuffer()),
+// so the file can be mapped into memory and used as the map without copying it
+typedef struct PagedHeader{
+    char magic[TILED_MAGIC_SIZE]; // PAGED_MAGIC
+    uint32_t version;             // PAGED_VERSION
+    int32_t width;                // Dimensions of the map
+    int32_t height;
+    int32_t stride;               // Distance between the beginning of two rows (in words)
+    int32_t originX;              // Position of the top left cell of the map on the plane
+    int32_t originY;
+    int32_t speed;                // Speed of the simulation
+    uint32_t rule;                // Rule of the simulation (see encodeRule(), version 1 files have padding here)
+    uint64_t byteOrder;           // PAGED_BYTE_ORDER
+} PagedHeader;
+
+// State of a tiled map file while it is written
+typedef struct TiledWriter{
+    FILE * fp;
+    uint64_t position;  // Number of bytes written so far
+    TileEntry * index;  // Entries of the written tiles
+    uint32_t numOfTiles;
+    uint32_t capacity;
+} TiledWriter;
+
+// Store an integer in little-endian byte order
+static void putLE(unsigned char * bytes, uint64_t value, int size){
+    for(int i = 0; i < size; i++){
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+// Read an integer stored in little-endian byte order
+// Return: The value
+static uint64_t getLE(const unsigned char * bytes, int size){
+    uint64_t value = 0;
+    for(int i = 0; i < size; i++){
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+// Move to the given position of the file (positions above 2 GB work on 32 bit builds too)
+// Return: TRUE on success, FALSE otherwise
+static bool seekFile(FILE * fp, uint64_t position){
+#ifdef _WIN32
+    return _fseeki64(fp, (long long)position, SEEK_SET) == 0;
+#else
+    return fseeko(fp, (off_t)position, SEEK_SET) == 0;
+#endif
+}
+
+// Get the size of the file (the position of the file is moved to its end)
+// Return: TRUE on success, FALSE if the size can't be determined
+static bool fileSize(FILE * fp, uint64_t * size){
+#ifdef _WIN32
+    long long end;
+    if(_fseeki64(fp, 0, SEEK_END) != 0 || (end = _ftelli64(fp)) < 0){
+        return false;
+    }
+#else
+    off_t end;
+    if(fseeko(fp, 0, SEEK_END) != 0 || (end = ftello(fp)) < 0){
+        return false;
+    }
+#endif
+    *size = (uint64_t)end;
+    return true;
+}
+
+// Compress the content of a tile with run-length encoding
+// A control byte below 128 is followed by control+1 literal bytes,
+// a control byte c of 128 or above is followed by one byte that is repeated c-125 times.
+// Return: Size of the compressed data
+static int packTile(const uint64_t rows[UNIVERSE_TILE_SIZE], unsigned char * packed){
+    unsigned char bytes[TILE_BYTES];
+    int size = 0, literal = -1, run;
+
+    for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+        putLE(&bytes[r * 8], rows[r], 8);
+    }
+    for(int i = 0; i < TILE_BYTES; i += run){
+        run = 1;
+        while(i + run < TILE_BYTES && run < 130 && bytes[i + run] == bytes[i]){
+            run++;
+        }
+        if(run >= 3){
+            packed[size++] = (unsigned char)(run + 125);
+            packed[size++] = bytes[i];
+            literal = -1;
+        } else {
+            // Short runs are added to the current literal block
+            run = 1;
+            if(literal < 0 || packed[literal] == 127){
+                literal = size++;
+                packed[literal] = 0;
+            } else {
+                packed[literal]++;
+            }
+            packed[size++] = bytes[i];
+        }
+    }
+    return size;
+}
+
+// Decompress the content of a tile
+// Return: TRUE if the data is valid, FALSE otherwise
+static bool unpackTile(const unsigned char * packed, int size, uint64_t rows[UNIVERSE_TILE_SIZE]){
+    unsigned char bytes[TILE_BYTES];
+    int length = 0, count, i = 0;
+
+    while(i < size){
+        if(packed[i] < 128){
+            count = packed[i] + 1;
+            if(i + 1 + count > size || length + count > TILE_BYTES){
+                return false;
+            }
+            memcpy(&bytes[length], &packed[i + 1], count);
+            i += 1 + count;
+        } else {
+            count = packed[i] - 125;
+            if(i + 1 >= size || length + count > TILE_BYTES){
+                return false;
+            }
+            memset(&bytes[length], packed[i + 1], count);
+            i += 2;
+        }
+        length += count;
+    }
+    if(length != TILE_BYTES){
+        return false;
+    }
+    for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+        rows[r] = getLE(&bytes[r * 8], 8);
+    }
+    return true;
+}
+
+// Write the header of a tiled map file
+// Return: TRUE on success, FALSE on a write error
+static bool writeTiledHeader(FILE * fp, const TiledHeader * header){
+    unsigned char bytes[TILED_HEADER_SIZE] = {0};
+    memcpy(bytes, TILED_MAGIC, TILED_MAGIC_SIZE);
+    putLE(&bytes[8], TILED_VERSION, 4);
+    putLE(&bytes[12], (uint32_t)header->width, 4);
+    putLE(&bytes[16], (uint32_t)header->height, 4);
+    putLE(&bytes[20], (uint32_t)header->originX, 4);
+    putLE(&bytes[24], (uint32_t)header->originY, 4);
+    putLE(&bytes[28], (uint32_t)header->speed, 4);
+    putLE(&bytes[32], header->numOfTiles, 4);
+    putLE(&bytes[36], header->rule, 4);
+    putLE(&bytes[40], header->indexOffset, 8);
+    return fwrite(bytes, 1, TILED_HEADER_SIZE, fp) == TILED_HEADER_SIZE;
+}
+
+// Read the header of a tiled map file (the magic bytes are already read)
+// Return: TRUE if the header is valid, FALSE otherwise
+static bool readTiledHeader(FILE * fp, TiledHeader * header){
+    unsigned char bytes[TILED_HEADER_SIZE];
+    if(fread(&bytes[TILED_MAGIC_SIZE], 1, TILED_HEADER_SIZE - TILED_MAGIC_SIZE, fp) != TILED_HEADER_SIZE - TILED_MAGIC_SIZE){
+        return false;
+    }
+    if(getLE(&bytes[8], 4) < 1 || getLE(&bytes[8], 4) > TILED_VERSION){
+        printf("Unsupported map file version: %u\n", (unsigned)getLE(&bytes[8], 4));
+        return false;
+    }
+    header->width = (int32_t)getLE(&bytes[12], 4);
+    header->height = (int32_t)getLE(&bytes[16], 4);
+    header->originX = (int32_t)getLE(&bytes[20], 4);
+    header->originY = (int32_t)getLE(&bytes[24], 4);
+    header->speed = (int32_t)getLE(&bytes[28], 4);
+    header->numOfTiles = (uint32_t)getLE(&bytes[32], 4);
+    // Bytes 36-39 were reserved in version 1
+    header->rule = getLE(&bytes[8], 4) == 1 ? encodeRule(RULE_CONWAY) : (uint32_t)getLE(&bytes[36], 4);
+    header->indexOffset = getLE(&bytes[40], 8);
+    return header->width >= 0 && header->height >= 0;
+}
+
+// Compress a tile and append it to the file (empty tiles are skipped)
+// Return: TRUE on success, FALSE on a write error
+static bool writeTile(TiledWriter * writer, int x, int y, const uint64_t rows[UNIVERSE_TILE_SIZE]){
+    unsigned char packed[MAX_PACKED_TILE];
+    uint64_t population = 0;
+    int size;
+
+    for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+        population |= rows[r];
+    }
+    if(population == 0){
+        return true;
+    }
+    if(writer->numOfTiles == writer->capacity){
+        writer->capacity = writer->capacity == 0 ? 256 : writer->capacity * 2;
+        writer->index = realloc(writer->index, writer->capacity * sizeof(TileEntry));
+        if(writer->index == NULL){
+            notEnoughMemory();
+        }
+    }
+    size = packTile(rows, packed);
+    writer->index[writer->numOfTiles++] = (TileEntry){x, y, writer->position, (uint32_t)size};
+    writer->position += size;
+    return fwrite(packed, 1, size, writer->fp) == (size_t)size;
+}
+
+// Write the tiles of the map (tile x, y holds the words x of the rows y*64 ... y*64+63)
+// Return: TRUE on success, FALSE on a write error
+static bool writeMapTiles(TiledWriter * writer, const Bitmap * map){
+    uint64_t rows[UNIVERSE_TILE_SIZE];
+    int tileRows = (map->height + UNIVERSE_TILE_SIZE - 1) / UNIVERSE_TILE_SIZE;
+    int y;
+
+    for(int ty = 0; ty < tileRows; ty++){
+        for(int tx = 0; tx < map->words; tx++){
+            for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+                y = ty * UNIVERSE_TILE_SIZE + r;
+                rows[r] = y < map->height ? mapRow(map, y)[tx] : 0;
+            }
+            if(!writeTile(writer, tx, ty, rows)){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Write the tile index at the end of the file, then the header with its position
+// Return: TRUE on success, FALSE on a write error
+static bool writeTileIndex(TiledWriter * writer, TiledHeader * header){
+    unsigned char entry[TILED_ENTRY_SIZE];
+    header->numOfTiles = writer->numOfTiles;
+    header->indexOffset = writer->position;
+    for(uint32_t i = 0; i < writer->numOfTiles; i++){
+        putLE(&entry[0], (uint32_t)writer->index[i].x, 4);
+        putLE(&entry[4], (uint32_t)writer->index[i].y, 4);
+        putLE(&entry[8], writer->index[i].offset, 8);
+        putLE(&entry[16], writer->index[i].size, 4);
+        if(fwrite(entry, 1, TILED_ENTRY_SIZE, writer->fp) != TILED_ENTRY_SIZE){
+            return false;
+        }
+    }
+    return seekFile(writer->fp, 0) && writeTiledHeader(writer->fp, header);
+}
+
+// Read the tile index of a tiled map file
+// Return: Array of the entries (must be freed), or NULL if the index is invalid
+static TileEntry * readTileIndex(FILE * fp, const TiledHeader * header){
+    unsigned char entry[TILED_ENTRY_SIZE];
+    TileEntry * index;
+    uint64_t size;
+
+    // The number of tiles comes from the file, the index must fit between its position and the end of the file
+    if(!fileSize(fp, &size) || header->indexOffset > size ||
+       header->numOfTiles > (size - header->indexOffset) / TILED_ENTRY_SIZE ||
+       (uint64_t)header->numOfTiles + 1 > SIZE_MAX / sizeof(TileEntry)){
+        return NULL;
+    }
+    if(!seekFile(fp, header->indexOffset)){
+        return NULL;
+    }
+    index = malloc(((size_t)header->numOfTiles + 1) * sizeof(TileEntry));
+    if(index == NULL){
+        notEnoughMemory();
+    }
+    for(uint32_t i = 0; i < header->numOfTiles; i++){
+        if(fread(entry, 1, TILED_ENTRY_SIZE, fp) != TILED_ENTRY_SIZE){
+            free(index);
+            return NULL;
+        }
+        index[i].x = (int32_t)getLE(&entry[0], 4);
+        index[i].y = (int32_t)getLE(&entry[4], 4);
+        index[i].offset = getLE(&entry[8], 8);
+        index[i].size = (uint32_t)getLE(&entry[16], 4);
+        // The cells of the tile must have int coordinates
+        if(index[i].size > MAX_PACKED_TILE ||
+           index[i].x < -(INT_MAX / UNIVERSE_TILE_SIZE - 1) || index[i].x > INT_MAX / UNIVERSE_TILE_SIZE - 1 ||
+           index[i].y < -(INT_MAX / UNIVERSE_TILE_SIZE - 1) || index[i].y > INT_MAX / UNIVERSE_TILE_SIZE - 1){
+            free(index);
+            return NULL;
+        }
+    }
+    return index;
+}
+
+// Copy the active cells of a tile to the map
+// (originX, originY: position of the top left cell of the map on the plane)
+static void tileToMap(const uint64_t rows[UNIVERSE_TILE_SIZE], int tileX, int tileY, Bitmap * map, int originX, int originY){
+    long long cellX, cellY;
+    uint64_t row;
+    for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+        cellY = (long long)tileY * UNIVERSE_TILE_SIZE + r - originY;
+        if(cellY < 0 || cellY >= map->height){
+            continue;
+        }
+        for(row = rows[r]; row != 0; row &= row - 1){
+            cellX = (long long)tileX * UNIVERSE_TILE_SIZE + __builtin_ctzll(row) - originX;
+            if(cellX >= 0 && cellX < map->width){
+                setCell(map, (int)cellX, (int)cellY, 1);
+            }
+        }
+    }
+}
+
+// Copy the active cells of a tile to the unbounded plane
+static void tileToUniverse(const uint64_t rows[UNIVERSE_TILE_SIZE], int tileX, int tileY, Universe * u){
+    uint64_t row;
+    for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+        for(row = rows[r]; row != 0; row &= row - 1){
+            setUniverseCell(u, tileX * UNIVERSE_TILE_SIZE + __builtin_ctzll(row), tileY * UNIVERSE_TILE_SIZE + r, 1);
+        }
+    }
+}
+
+// Checks if the tile has cells inside the map
+// Return: TRUE if the tile overlaps the map, FALSE otherwise
+static bool tileInsideMap(int tileX, int tileY, const Bitmap * map, int originX, int originY){
+    long long left = (long long)tileX * UNIVERSE_TILE_SIZE - originX;
+    long long top = (long long)tileY * UNIVERSE_TILE_SIZE - originY;
+    return left + UNIVERSE_TILE_SIZE > 0 && left < map->width && top + UNIVERSE_TILE_SIZE > 0 && top < map->height;
+}
+
+// Load a tiled map file (the magic bytes are already read)
+// Only the tiles in the index are read, the tiles outside of a bounded map are skipped
+// Return: TRUE on success, FALSE if the file is invalid
+static bool loadTiledMap(Simulation * sim, FILE * fp){
+    TiledHeader header;
+    TileEntry * index;
+    unsigned char packed[MAX_PACKED_TILE];
+    uint64_t rows[UNIVERSE_TILE_SIZE];
+    uint64_t position;
+    bool valid = true;
+    Rule rule;
+
+    if(!readTiledHeader(fp, &header) || !decodeRule(header.rule, &rule) ||
+       (index = readTileIndex(fp, &header)) == NULL){
+        return false;
+    }
+    if(sim->universe == NULL && !validDimensions(header.width, header.height)){
+        free(index);
+        return false;
+    }
+    if(sim->universe != NULL){
+        // The tiles keep their position on the unbounded plane
+        clearUniverse(sim->universe);
+    } else {
+        simulation_resize(sim, header.width, header.height);
+    }
+    position = (uint64_t)-1;
+    for(uint32_t i = 0; i < header.numOfTiles && valid; i++){
+        if(sim->universe == NULL && !tileInsideMap(index[i].x, index[i].y, &sim->map, header.originX, header.originY)){
+            continue;
+        }
+        // The tiles are stored in the order of the index, so a seek is only needed after a skipped tile
+        if(position != index[i].offset && !seekFile(fp, index[i].offset)){
+            valid = false;
+            break;
+        }
+        position = index[i].offset + index[i].size;
+        valid = fread(packed, 1, index[i].size, fp) == index[i].size && unpackTile(packed, index[i].size, rows);
+        if(!valid){
+            break;
+        }
+        if(sim->universe != NULL){
+            tileToUniverse(rows, index[i].x, index[i].y, sim->universe);
+        } else {
+            tileToMap(rows, index[i].x, index[i].y, &sim->map, header.originX, header.originY);
+        }
+    }
+    free(index);
+    if(sim->universe == NULL){
+        markAllTilesChanged(sim);
+    }
+    if(!valid){
+        // The rule and the speed of an invalid file are not applied
+        return false;
+    }
+    sim->speed = header.speed >= SPEED_UNLIMITED && header.speed <= MAX_SPEED ? header.speed : 1;
+    setRule(sim, rule);
+    return true;
+}
+
+// Write the map in the page-aligned format
+// Return: TRUE on success, FALSE on a write error
+static bool writePagedMap(FILE * fp, const Bitmap * map, int originX, int originY, int speed, Rule rule){
+    static const char padding[BITMAP_FILE_HEADER];
+    PagedHeader header = {0};
+    memcpy(header.magic, PAGED_MAGIC, TILED_MAGIC_SIZE);
+    header.version = PAGED_VERSION;
+    header.width = map->width;
+    header.height = map->height;
+    header.stride = map->stride;
+    header.originX = originX;
+    header.originY = originY;
+    header.speed = speed;
+    header.rule = encodeRule(rule);
+    header.byteOrder = PAGED_BYTE_ORDER;
+    return fwrite(&header, sizeof(header), 1, fp) == 1 &&
+           fwrite(padding, 1, BITMAP_FILE_HEADER - sizeof(header), fp) == BITMAP_FILE_HEADER - sizeof(header) &&
+           fwrite(mapBuffer(map), 1, mapBufferSize(map), fp) == mapBufferSize(map);
+}
+
+// Read the whole buffer of a page-aligned map file (used when the file can't be mapped)
+// Return: TRUE on success, FALSE if the file is too short
+static bool readPagedBuffer(FILE * fp, Bitmap * map){
+    return seekFile(fp, BITMAP_FILE_HEADER) &&
+           fread((void *)mapBuffer(map), 1, mapBufferSize(map), fp) == mapBufferSize(map);
+}
+
+// Load a page-aligned map file (the magic bytes are already read)
+// On a bounded map the file is mapped into memory with copy-on-write and used as the map,
+// so loading takes the same time for any size and the pages are only read when
+// the simulation or the view touches them.
+// Return: TRUE on success, FALSE if the file is invalid
+static bool loadPagedMap(Simulation * sim, FILE * fp, const char * path){
+    PagedHeader header;
+    Bitmap map;
+    Rule rule;
+
+    memcpy(header.magic, PAGED_MAGIC, TILED_MAGIC_SIZE);
+    if(fread((char *)&header + TILED_MAGIC_SIZE, sizeof(header) - TILED_MAGIC_SIZE, 1, fp) != 1){
+        return false;
+    }
+    if(header.version < 1 || header.version > PAGED_VERSION || header.byteOrder != PAGED_BYTE_ORDER){
+        printf("Unsupported map file version or byte order\n");
+        return false;
+    }
+    if(header.version == 1){
+        rule = RULE_CONWAY;
+    } else if(!decodeRule(header.rule, &rule)){
+        return false;
+    }
+    if(!validDimensions(header.width, header.height)){
+        return false;
+    }
+    // The layout of the rows must be the same as the layout of the maps of this program
+    if(!bitmap_mapFile(&map, path, header.width, header.height)){
+        // The file is too large for the address space or it can't be mapped, it is read instead
+        map = bitmap_init(header.width, header.height);
+        if(map.stride != header.stride || !readPagedBuffer(fp, &map)){
+            bitmap_free(&map);
+            return false;
+        }
+    } else if(map.stride != header.stride){
+        bitmap_free(&map);
+        return false;
+    }
+
+    if(sim->universe != NULL){
+        clearUniverse(sim->universe);
+        mapToUniverse(sim->universe, &map, header.originX, header.originY);
+        bitmap_free(&map);
+    } else {
+        simulation_resize(sim, header.width, header.height);
+        bitmap_free(&sim->map);
+        sim->map = map;
+        markAllTilesChanged(sim);
+    }
+    sim->speed = header.speed >= SPEED_UNLIMITED && header.speed <= MAX_SPEED ? header.speed : 1;
+    setRule(sim, rule);
+    return true;
+}
+
+// Read the cells of a map in the legacy format (the dimensions and the speed are already read)
+// Return: TRUE on success, FALSE if the file ends before the last cell
+static bool readLegacyCells(FILE * fp, Bitmap * map){
+    unsigned char bitEncodedField = 0;
+    unsigned char bit;
+    int c;
+
+    for(int i = 0; i < map->height; i++){
+        bit = 0;
+        for(int j = 0; j < map->width; j++){
+            if(bit == 0){
+                if((c = fgetc(fp)) == EOF){
+                    return false;
+                }
+                bitEncodedField = (unsigned char)c;
+            }
+            setCell(map, j, i, (bitEncodedField >> bit) & 0x1);
+            bit++;
+            if(bit == 8){
+                bit = 0;
+            }
+        }
+        // Skip new line character
+        // (older versions wrote an extra byte before it when the width is a multiple of 8)
+        if(fgetc(fp) != '\n'){
+            fgetc(fp);
+        }
+    }
+    return true;
+}
+
+// Load a map in the legacy format: a "WIDTHxHEIGHT" and a speed line, then every row bit-packed
+// Return: TRUE on success, FALSE if the file is invalid
+static bool loadLegacyMap(Simulation * sim, FILE * fp){
+    int width, height, speed;
+    Bitmap map;
+
+    // The new line characters are read one by one, because a whitespace in the format
+    // would skip the bytes of the first row that look like whitespace
+    if(fscanf(fp, "%dx%d", &width, &height) != 2 || fgetc(fp) != '\n' ||
+       fscanf(fp, "%d", &speed) != 1 || fgetc(fp) != '\n' || !validDimensions(width, height)){
+        return false;
+    }
+
+    // The cells are read to a new map, so a truncated file keeps the previous map
+    map = bitmap_init(width, height);
+    if(!readLegacyCells(fp, &map)){
+        bitmap_free(&map);
+        return false;
+    }
+    if(sim->universe != NULL){
+        // The map is placed on the unbounded plane with its top left corner at the origin
+        clearUniverse(sim->universe);
+        mapToUniverse(sim->universe, &map, 0, 0);
+        bitmap_free(&map);
+    } else {
+        simulation_resize(sim, width, height);
+        bitmap_free(&sim->map);
+        sim->map = map;
+        markAllTilesChanged(sim);
+    }
+    sim->speed = speed >= SPEED_UNLIMITED && speed <= MAX_SPEED ? speed : 1;
+    return true;
+}
+
+// Place an imported pattern on the simulation
+// On a bounded map that is large enough the pattern is centered, otherwise the map is resized to the pattern.
+// On the unbounded plane the top left corner of the pattern is the origin.
+static void placePattern(Simulation * sim, const Bitmap * pattern){
+    int x, y;
+    uint64_t word;
+
+    if(sim->universe != NULL){
+        clearUniverse(sim->universe);
+        mapToUniverse(sim->universe, pattern, 0, 0);
+        return;
+    }
+    if(pattern->width > sim->size.width || pattern->height > sim->size.height){
+        simulation_resize(sim, pattern->width, pattern->height);
+    } else {
+        forgetPastGenerations(sim);
+        preserveAllTiles(&sim->checkpoints, &sim->map);
+        clearMap(&sim->map);
+    }
+    x = (sim->size.width - pattern->width) / 2;
+    y = (sim->size.height - pattern->height) / 2;
+    for(int r = 0; r < pattern->height; r++){
+        for(int w = 0; w < pattern->words; w++){
+            for(word = mapRow(pattern, r)[w]; word != 0; word &= word - 1){
+                setCell(&sim->map, x + w * WORD_BITS + __builtin_ctzll(word), y + r, 1);
+            }
+        }
+    }
+    markAllTilesChanged(sim);
+}
+
+// Read the rule of an RLE header ("rule = B36/S23", the header may have no rule)
+// A rule this program can't simulate is reported, and the current rule is kept.
+// Return: TRUE if the header has a supported rule, FALSE otherwise
+static bool importRleRule(const char * header, Rule * rule){
+    const char * value = strstr(header, "rule");
+    char text[64];
+    if(value == NULL || sscanf(value, "rule = %63[^, \t\r\n]", text) != 1){
+        return false;
+    }
+    if(!parseRule(text, rule)){
+        printf("Unsupported rule in the pattern: %s (the current rule is kept)\n", text);
+        return false;
+    }
+    return true;
+}
+
+// Read a line of a text file (the characters that don't fit in the buffer are skipped)
+// Return: TRUE on success, FALSE at the end of the file
+static bool readLine(FILE * fp, char * line, int size){
+    int length = 0, c;
+    while((c = fgetc(fp)) != EOF && c != '\n'){
+        if(length < size - 1){
+            line[length++] = (char)c;
+        }
+    }
+    line[length] = '\0';
+    return c != EOF || length > 0;
+}
+
+// Import a pattern in the RLE format ("x = W, y = H, rule = R" header, then runs of b (dead), o (alive) and $ (end of row))
+// Return: TRUE on success, FALSE if the file is invalid
+static bool importRle(Simulation * sim, FILE * fp){
+    char line[256];
+    int width = -1, height = -1;
+    int x = 0, y = 0, c;
+    long long count = 0;
+    bool hasRule = false;
+    Rule rule;
+    Bitmap pattern;
+
+    // Comment lines start with #, the first other line is the header
+    while(readLine(fp, line, sizeof(line))){
+        if(line[0] == '#'){
+            continue;
+        }
+        if(sscanf(line, " x = %d , y = %d", &width, &height) != 2){
+            return false;
+        }
+        hasRule = importRleRule(line, &rule);
+        break;
+    }
+    if(!validDimensions(width, height)){
+        return false;
+    }
+    pattern = bitmap_init(width, height);
+    while((c = fgetc(fp)) != EOF && c != '!'){
+        if(isdigit(c)){
+            if(count > ((long long)width * height - (c - '0')) / 10){
+                // A run longer than the whole pattern
+                bitmap_free(&pattern);
+                return false;
+            }
+            count = count * 10 + (c - '0');
+            continue;
+        }
+        if(count == 0){
+            count = 1;
+        }
+        // The cells past the edges of the pattern are dropped, so the position stops at the edge
+        if(c == '$'){
+            y = count < height - y ? y + (int)count : height;
+            x = 0;
+        } else if(c == 'b' || c == '.'){
+            x = count < width - x ? x + (int)count : width;
+        } else if(isalpha(c)){
+            // Every state other than b is alive
+            for(; count > 0 && x < width; count--, x++){
+                if(y < height){
+                    setCell(&pattern, x, y, 1);
+                }
+            }
+        } else {
+            // Whitespace and new lines separate nothing
+            continue;
+        }
+        count = 0;
+    }
+    placePattern(sim, &pattern);
+    bitmap_free(&pattern);
+    // The rule is only applied when the whole file was read
+    if(hasRule){
+        setRule(sim, rule);
+    }
+    return true;
+}
+
+// Import a pattern in the plaintext format (lines starting with ! are comments, O is alive, . is dead)
+// Return: TRUE on success, FALSE if the file is invalid
+static bool importCells(Simulation * sim, FILE * fp){
+    int width = 0, height = 0, x = 0, c;
+    bool comment = false, lineStart = true;
+    Bitmap pattern;
+
+    // First pass: dimensions of the pattern
+    while((c = fgetc(fp)) != EOF){
+        if(lineStart){
+            comment = c == '!';
+            lineStart = false;
+        }
+        if(c == '\n'){
+            if(!comment){
+                height++;
+            }
+            x = 0;
+            lineStart = true;
+        } else if(!comment && c != '\r'){
+            x++;
+            width = x > width ? x : width;
+        }
+    }
+    if(!lineStart && !comment){
+        height++;
+    }
+    if(!validDimensions(width, height)){
+        return false;
+    }
+    // Second pass: cells
+    pattern = bitmap_init(width, height);
+    rewind(fp);
+    x = 0;
+    height = 0;
+    lineStart = true;
+    while((c = fgetc(fp)) != EOF){
+        if(lineStart){
+            comment = c == '!';
+            lineStart = false;
+        }
+        if(c == '\n'){
+            if(!comment){
+                height++;
+            }
+            x = 0;
+            lineStart = true;
+        } else if(!comment && c != '\r'){
+            if(c == 'O' || c == '*'){
+                setCell(&pattern, x, height, 1);
+            }
+            x++;
+        }
+    }
+    placePattern(sim, &pattern);
+    bitmap_free(&pattern);
+    return true;
+}
+
+// Checks if the path ends with the given extension (case-insensitive)
+// Return: TRUE if it does, FALSE otherwise
+static bool hasExtension(const char * path, const char * extension){
+    const char * dot = strrchr(path, '.');
+    if(dot == NULL){
+        return false;
+    }
+    for(; *dot != '\0' && *extension != '\0'; dot++, extension++){
+        if(tolower((unsigned char)*dot) != *extension){
+            return false;
+        }
+    }
+    return *dot == '\0' && *extension == '\0';
+}
+
+// Save the state of the simulation in the page-aligned format
+// Return: TRUE on success, FALSE on a write error
+static bool savePagedMap(Simulation * sim, FILE * fp){
+    int x = 0, y = 0, width = 0, height = 0;
+    Bitmap map;
+    bool success;
+    if(sim->universe == NULL){
+        return writePagedMap(fp, &sim->map, 0, 0, sim->speed, sim->rule);
+    }
+    // The unbounded plane is saved as the rectangle that contains every active cell
+    universeBounds(sim->universe, &x, &y, &width, &height);
+    map = bitmap_init(width, height);
+    universeToMap(sim->universe, &map, x, y);
+    success = writePagedMap(fp, &map, x, y, sim->speed, sim->rule);
+    bitmap_free(&map);
+    return success;
+}
+
+// Save the state of the simulation in the tiled format
+// Return: TRUE on success, FALSE on a write error
+static bool saveTiledMap(Simulation * sim, FILE * fp){
+    TiledHeader header = {0};
+    TiledWriter writer = {0};
+    Tile * tile;
+    bool success;
+
+    writer.fp = fp;
+    writer.position = TILED_HEADER_SIZE;
+    header.speed = sim->speed;
+    header.rule = encodeRule(sim->rule);
+    // The header is written again with the position of the index at the end
+    success = writeTiledHeader(fp, &header);
+    if(sim->universe != NULL){
+        // The tiles of the unbounded plane keep their position, the map is their bounding box
+        universeBounds(sim->universe, &header.originX, &header.originY, &header.width, &header.height);
+        for(int i = 0; i < sim->universe->numOfTiles && success; i++){
+            tile = sim->universe->tiles[i];
+            success = writeTile(&writer, tile->x, tile->y, tile->cells);
+        }
+    } else {
+        header.width = sim->map.width;
+        header.height = sim->map.height;
+        success = success && writeMapTiles(&writer, &sim->map);
+    }
+    success = success && writeTileIndex(&writer, &header);
+    free(writer.index);
+    return success;
+}
+
+// Replace a file with another one
+// Return: TRUE on success, FALSE otherwise
+static bool replaceFile(const char * from, const char * to){
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+// Save the current state of the simulation to the given file
+// Files ending in .bits are saved in the page-aligned format that is loaded without copying,
+// other files in the tiled format
+// The map is written to a temporary file first, which replaces the file when it is complete,
+// so the file is not lost if the saving fails
+// Return: TRUE on success, FALSE if the file can't be written
+bool saveMapFile(Simulation * sim, const char * path){
+    Uint64 start = SDL_GetPerformanceCounter();
+    char * tempPath = malloc(strlen(path) + 5);
+    FILE * fp;
+    bool success;
+
+    if(tempPath == NULL){
+        notEnoughMemory();
+    }
+    sprintf(tempPath, "%s.tmp", path);
+    // The map may be a mapping of the file that is replaced, so it is read into memory first
+    bitmap_unmapFile(&sim->map);
+    bitmap_unmapFile(&sim->tempMap);
+    fp = fopen(tempPath, "wb");
+    if(fp == NULL){
+        printf("Error when saving map.\n(%s can't be opened)\n", tempPath);
+        free(tempPath);
+        return false;
+    }
+    setvbuf(fp, NULL, _IOFBF, FILE_BUFFER_SIZE);
+    if(hasExtension(path, ".bits")){
+        success = savePagedMap(sim, fp);
+    } else {
+        success = saveTiledMap(sim, fp);
+    }
+    if(fclose(fp) != 0 || !success){
+        printf("Error when saving map.\n(%s can't be written)\n", tempPath);
+        remove(tempPath);
+        free(tempPath);
+        return false;
+    }
+    if(!replaceFile(tempPath, path)){
+        printf("Error when saving map.\n(%s can't be replaced)\n", path);
+        remove(tempPath);
+        free(tempPath);
+        return false;
+    }
+    free(tempPath);
+    stopTimer(&sim->stats.io, start);
+    return true;
+}
+
+// Load the simulation from the given file
+// Tiled, page-aligned and legacy map files are recognized by their content, .rle and .cells patterns by the extension
+// (a map of different size reinitializes the simulation)
+// Return: TRUE on success, FALSE if the file can't be opened or it is invalid
+bool loadMapFile(Simulation * sim, const char * path){
+    Uint64 start = SDL_GetPerformanceCounter();
+    FILE * fp = fopen(path, "rb");
+    char magic[TILED_MAGIC_SIZE] = {0};
+    bool success;
+
+    if(fp == NULL){
+        printf("Error when loading map.\n(%s doesn't exist)\n", path);
+        return false;
+    }
+    setvbuf(fp, NULL, _IOFBF, FILE_BUFFER_SIZE);
+
+    if(hasExtension(path, ".rle")){
+        success = importRle(sim, fp);
+    } else if(hasExtension(path, ".cells")){
+        success = importCells(sim, fp);
+    } else if(fread(magic, 1, TILED_MAGIC_SIZE, fp) == TILED_MAGIC_SIZE && memcmp(magic, TILED_MAGIC, TILED_MAGIC_SIZE) == 0){
+        success = loadTiledMap(sim, fp);
+    } else if(memcmp(magic, PAGED_MAGIC, TILED_MAGIC_SIZE) == 0){
+        success = loadPagedMap(sim, fp, path);
+    } else {
+        rewind(fp);
+        success = loadLegacyMap(sim, fp);
+    }
+    fclose(fp);
+    if(!success){
+        printf("Error when loading map.\n(%s is not a valid map)\n", path);
+        return false;
+    }
+
+    // Taking a checkpoint doesn't copy the map, so a mapped file is not read by it
+    saveCheckpoint(sim, DEFAULT_CHECKPOINT);
+    forgetPastGenerations(sim);
+    stopTimer(&sim->stats.io, start);
+    return true;
+}
+
+// Save the current state of the simulation to the map file of the simulation
+void saveSimulationToFile(Simulation * sim){
+    saveMapFile(sim, sim->mapFile);
+}
+
+// Load simulation from the map file of the simulation
+void loadSimulationFromFile(Simulation * sim){
+    loadMapFile(sim, sim->mapFile);
 }
\ No newline at end of file
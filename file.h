@@ -1,13 +1,26 @@
-#ifndef FILE_H
-#define FILE_H
-
-#include <SDL2/SDL.h>
-#include "simulation.h"
-
-// Save the current state of the simulation
-void saveSimulationToFile(Simulation * sim);
-
-// Load simulation from file
-void loadSimulationFromFile(Simulation * sim, SDL_TimerID * timer);
-
+#ifndef FILE_H
+#define FILE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "simulation.h"
+
+// Save the current state of the simulation to the given file
+// Files ending in .bits are saved in the page-aligned format that is loaded without copying,
+// other files in the tiled format
+// Return: TRUE on success, FALSE if the file can't be written
+bool saveMapFile(Simulation * sim, const char * path);
+
+// Load the simulation from the given file
+// Tiled, page-aligned and legacy map files are recognized by their content, .rle and .cells patterns by the extension
+// (a map of different size reinitializes the simulation)
+// Return: TRUE on success, FALSE if the file can't be opened or it is invalid
+bool loadMapFile(Simulation * sim, const char * path);
+
+// Save the current state of the simulation to the map file of the simulation
+void saveSimulationToFile(Simulation * sim);
+
+// Load simulation from the map file of the simulation
+void loadSimulationFromFile(Simulation * sim);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,506 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "error.h"
+#include "hashlife.h"
+
+// Number of nodes allocated at once
+#define NODES_PER_BLOCK 4096
+
+// Initial size of the hash table
+#define INITIAL_BUCKETS 65536
+
+// Highest level of the root (the coordinates of the plane are 64 bit integers)
+#define MAX_LEVEL 60
+
+// Level of the nodes whose area fits in a word of the map
+#define WORD_LEVEL 6
+
+// Hash of the quadrants of a node
+// Return: Hash value
+static size_t nodeHash(const Node * nw, const Node * ne, const Node * sw, const Node * se){
+    uint64_t h = (uint64_t)(uintptr_t)nw;
+    h = h * 0x9E3779B97F4A7C15ull + (uint64_t)(uintptr_t)ne;
+    h = h * 0x9E3779B97F4A7C15ull + (uint64_t)(uintptr_t)sw;
+    h = h * 0x9E3779B97F4A7C15ull + (uint64_t)(uintptr_t)se;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+// Get an unused node (from the free list or a newly allocated block)
+// Return: Pointer to the node
+static Node * allocNode(HashLife * hl){
+    NodeBlock * block;
+    Node * node;
+    if(hl->freeNodes == NULL){
+        block = malloc(sizeof(NodeBlock) + NODES_PER_BLOCK * sizeof(Node));
+        if(block == NULL){
+            notEnoughMemory();
+        }
+        block->next = hl->blocks;
+        hl->blocks = block;
+        hl->numOfBlocks++;
+        for(int i = NODES_PER_BLOCK - 1; i >= 0; i--){
+            block->nodes[i].level = -1;
+            block->nodes[i].next = hl->freeNodes;
+            hl->freeNodes = &block->nodes[i];
+        }
+    }
+    node = hl->freeNodes;
+    hl->freeNodes = node->next;
+    return node;
+}
+
+// Double the size of the hash table
+static void growHashTable(HashLife * hl){
+    size_t numOfBuckets = hl->numOfBuckets * 2;
+    Node ** buckets = calloc(numOfBuckets, sizeof(Node *));
+    Node * node, * next;
+    size_t index;
+    if(buckets == NULL){
+        // Keep the current table, the chains just get longer
+        return;
+    }
+    for(size_t i = 0; i < hl->numOfBuckets; i++){
+        for(node = hl->buckets[i]; node != NULL; node = next){
+            next = node->next;
+            index = nodeHash(node->nw, node->ne, node->sw, node->se) & (numOfBuckets - 1);
+            node->next = buckets[index];
+            buckets[index] = node;
+        }
+    }
+    free(hl->buckets);
+    hl->buckets = buckets;
+    hl->numOfBuckets = numOfBuckets;
+}
+
+// Get the canonical node with the given quadrants
+// Return: Pointer to the node
+static Node * findNode(HashLife * hl, Node * nw, Node * ne, Node * sw, Node * se){
+    size_t index = nodeHash(nw, ne, sw, se) & (hl->numOfBuckets - 1);
+    Node * node;
+    for(node = hl->buckets[index]; node != NULL; node = node->next){
+        if(node->nw == nw && node->ne == ne && node->sw == sw && node->se == se){
+            return node;
+        }
+    }
+    node = allocNode(hl);
+    node->nw = nw;
+    node->ne = ne;
+    node->sw = sw;
+    node->se = se;
+    node->result = NULL;
+    node->population = nw->population + ne->population + sw->population + se->population;
+    node->level = nw->level + 1;
+    node->marked = false;
+    node->next = hl->buckets[index];
+    hl->buckets[index] = node;
+    hl->numOfNodes++;
+    if(hl->numOfNodes > hl->numOfBuckets){
+        growHashTable(hl);
+    }
+    return node;
+}
+
+// Get the empty node of the given level
+// Return: Pointer to the node
+static Node * emptyNode(HashLife * hl, int level){
+    Node * node = hl->dead;
+    for(int i = 0; i < level; i++){
+        node = findNode(hl, node, node, node, node);
+    }
+    return node;
+}
+
+// Get the center of the node (one level lower)
+// Return: Pointer to the node
+static Node * centeredNode(HashLife * hl, Node * n){
+    return findNode(hl, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+// Calculate the center 2x2 cells of a 4x4 node after one generation with the rule of the universe
+// Return: Node of level 1
+static Node * baseResult(HashLife * hl, Node * n){
+    int cells[4][4];
+    int neighbours;
+    Node * next[2][2];
+    Node * quadrants[2][2] = {{n->nw, n->ne}, {n->sw, n->se}};
+
+    for(int qy = 0; qy < 2; qy++){
+        for(int qx = 0; qx < 2; qx++){
+            cells[qy * 2][qx * 2]         = quadrants[qy][qx]->nw == hl->alive;
+            cells[qy * 2][qx * 2 + 1]     = quadrants[qy][qx]->ne == hl->alive;
+            cells[qy * 2 + 1][qx * 2]     = quadrants[qy][qx]->sw == hl->alive;
+            cells[qy * 2 + 1][qx * 2 + 1] = quadrants[qy][qx]->se == hl->alive;
+        }
+    }
+    for(int y = 1; y <= 2; y++){
+        for(int x = 1; x <= 2; x++){
+            neighbours = 0;
+            for(int j = -1; j <= 1; j++){
+                for(int i = -1; i <= 1; i++){
+                    if(i != 0 || j != 0){
+                        neighbours += cells[y + j][x + i];
+                    }
+                }
+            }
+            if(nextCellState(hl->rule, cells[y][x], neighbours)){
+                next[y - 1][x - 1] = hl->alive;
+            } else {
+                next[y - 1][x - 1] = hl->dead;
+            }
+        }
+    }
+    return findNode(hl, next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+// Keep a node during the advance in progress (the garbage collector keeps the nodes on the stack)
+// Return: The node
+static Node * protect(HashLife * hl, Node * node){
+    Node ** stack;
+    if(hl->stackSize == hl->stackCapacity){
+        stack = realloc(hl->stack, (hl->stackCapacity == 0 ? 256 : hl->stackCapacity * 2) * sizeof(Node *));
+        if(stack == NULL){
+            notEnoughMemory();
+        }
+        hl->stack = stack;
+        hl->stackCapacity = hl->stackCapacity == 0 ? 256 : hl->stackCapacity * 2;
+    }
+    hl->stack[hl->stackSize++] = node;
+    return node;
+}
+
+// Calculate the center of the node after min(2^(level-2), 2^step) generations
+// The garbage collector may run at the beginning, so every node held by the callers must be on the stack
+// (see protect()); the quadrants of a protected node are kept as well
+// Return: Node one level lower
+static Node * successor(HashLife * hl, Node * n){
+    Node * n00, * n01, * n02, * n10, * n11, * n12, * n20, * n21, * n22;
+    Node * r00, * r01, * r02, * r10, * r11, * r12, * r20, * r21, * r22;
+    Node * result;
+    size_t stackSize = hl->stackSize;
+
+    if(n->result != NULL){
+        return n->result;
+    }
+    protect(hl, n);
+    if(hl->numOfNodes * sizeof(Node) > hl->collectLimit){
+        collectGarbage(hl);
+    }
+    if(n->population == 0){
+        result = n->nw;
+    } else if(n->level == 2){
+        result = baseResult(hl, n);
+    } else {
+        // Nine overlapping subnodes of half size
+        n00 = n->nw;
+        n01 = protect(hl, findNode(hl, n->nw->ne, n->ne->nw, n->nw->se, n->ne->sw));
+        n02 = n->ne;
+        n10 = protect(hl, findNode(hl, n->nw->sw, n->nw->se, n->sw->nw, n->sw->ne));
+        n11 = protect(hl, findNode(hl, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw));
+        n12 = protect(hl, findNode(hl, n->ne->sw, n->ne->se, n->se->nw, n->se->ne));
+        n20 = n->sw;
+        n21 = protect(hl, findNode(hl, n->sw->ne, n->se->nw, n->sw->se, n->se->sw));
+        n22 = n->se;
+        if(hl->step >= n->level - 2){
+            // Full speed: both halves of the time are advanced recursively
+            r00 = protect(hl, successor(hl, n00));
+            r01 = protect(hl, successor(hl, n01));
+            r02 = protect(hl, successor(hl, n02));
+            r10 = protect(hl, successor(hl, n10));
+            r11 = protect(hl, successor(hl, n11));
+            r12 = protect(hl, successor(hl, n12));
+            r20 = protect(hl, successor(hl, n20));
+            r21 = protect(hl, successor(hl, n21));
+            r22 = protect(hl, successor(hl, n22));
+        } else {
+            // Slower step: only the second half advances the time
+            r00 = protect(hl, centeredNode(hl, n00));
+            r01 = protect(hl, centeredNode(hl, n01));
+            r02 = protect(hl, centeredNode(hl, n02));
+            r10 = protect(hl, centeredNode(hl, n10));
+            r11 = protect(hl, centeredNode(hl, n11));
+            r12 = protect(hl, centeredNode(hl, n12));
+            r20 = protect(hl, centeredNode(hl, n20));
+            r21 = protect(hl, centeredNode(hl, n21));
+            r22 = protect(hl, centeredNode(hl, n22));
+        }
+        result = findNode(hl,
+                          protect(hl, successor(hl, protect(hl, findNode(hl, r00, r01, r10, r11)))),
+                          protect(hl, successor(hl, protect(hl, findNode(hl, r01, r02, r11, r12)))),
+                          protect(hl, successor(hl, protect(hl, findNode(hl, r10, r11, r20, r21)))),
+                          protect(hl, successor(hl, protect(hl, findNode(hl, r11, r12, r21, r22)))));
+    }
+    hl->stackSize = stackSize;
+    n->result = result;
+    return result;
+}
+
+// Forget the memoised results of every node
+static void clearResults(HashLife * hl){
+    for(size_t i = 0; i < hl->numOfBuckets; i++){
+        for(Node * node = hl->buckets[i]; node != NULL; node = node->next){
+            node->result = NULL;
+        }
+    }
+}
+
+// Surround the root with an empty border (the root gets one level higher)
+static void expandRoot(HashLife * hl){
+    Node * root = hl->root;
+    Node * e = emptyNode(hl, root->level - 1);
+    hl->root = findNode(hl,
+                        findNode(hl, e, e, e, root->nw),
+                        findNode(hl, e, e, root->ne, e),
+                        findNode(hl, e, root->sw, e, e),
+                        findNode(hl, root->se, e, e, e));
+    hl->originX -= (int64_t)1 << (root->level - 1);
+    hl->originY -= (int64_t)1 << (root->level - 1);
+}
+
+// Initialize an empty universe
+// memoryLimit: the node cache is collected when it gets larger than this (in bytes)
+// Return: Pointer to the universe
+HashLife * hashlife_init(size_t memoryLimit){
+    HashLife * hl = calloc(1, sizeof(HashLife));
+    if(hl == NULL){
+        notEnoughMemory();
+    }
+    hl->numOfBuckets = INITIAL_BUCKETS;
+    hl->buckets = calloc(hl->numOfBuckets, sizeof(Node *));
+    if(hl->buckets == NULL){
+        notEnoughMemory();
+    }
+    hl->memoryLimit = memoryLimit;
+    hl->collectLimit = memoryLimit;
+    hl->rule = RULE_CONWAY;
+    // The level 0 nodes are not in the hash table, so they are never collected
+    hl->dead = allocNode(hl);
+    hl->alive = allocNode(hl);
+    *hl->dead = (Node){NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, false};
+    *hl->alive = (Node){NULL, NULL, NULL, NULL, NULL, NULL, 1, 0, false};
+    hl->root = emptyNode(hl, 3);
+    return hl;
+}
+
+// Frees the memory allocated by the universe
+void hashlife_free(HashLife * hl){
+    NodeBlock * block, * next;
+    if(hl == NULL){
+        return;
+    }
+    for(block = hl->blocks; block != NULL; block = next){
+        next = block->next;
+        free(block);
+    }
+    free(hl->buckets);
+    free(hl->stack);
+    free(hl);
+}
+
+// Build the node of the given level from the square area of a tile at (x, y)
+// Return: Pointer to the node
+static Node * nodeFromTile(HashLife * hl, const uint64_t * rows, int level, int x, int y){
+    int size = 1 << level;
+    uint64_t mask = size == WORD_BITS ? ~(uint64_t)0 : ((((uint64_t)1 << size) - 1) << x);
+    bool empty = true;
+    for(int r = y; r < y + size && empty; r++){
+        empty = (rows[r] & mask) == 0;
+    }
+    if(empty){
+        return emptyNode(hl, level);
+    }
+    if(level == 0){
+        return hl->alive;
+    }
+    size /= 2;
+    return findNode(hl,
+                    nodeFromTile(hl, rows, level - 1, x, y),
+                    nodeFromTile(hl, rows, level - 1, x + size, y),
+                    nodeFromTile(hl, rows, level - 1, x, y + size),
+                    nodeFromTile(hl, rows, level - 1, x + size, y + size));
+}
+
+// Move the tiles before the given column (vertical: before the given row) to the front
+// Return: Number of tiles moved to the front
+static int partitionTiles(HashLifeTile * tiles, int numOfTiles, bool vertical, int64_t split){
+    HashLifeTile tmp;
+    int front = 0;
+    for(int i = 0; i < numOfTiles; i++){
+        if((vertical ? tiles[i].y : tiles[i].x) < split){
+            tmp = tiles[front];
+            tiles[front] = tiles[i];
+            tiles[i] = tmp;
+            front++;
+        }
+    }
+    return front;
+}
+
+// Build the node of the given level from the tiles inside its area
+// (x, y: position of the node in tiles; only the tiles inside the area are given)
+// Return: Pointer to the node
+static Node * nodeFromTiles(HashLife * hl, HashLifeTile * tiles, int numOfTiles, int level, int64_t x, int64_t y){
+    int64_t half;
+    int top, topLeft, bottomLeft;
+    if(numOfTiles == 0){
+        return emptyNode(hl, level);
+    }
+    if(level == WORD_LEVEL){
+        return nodeFromTile(hl, tiles[0].rows, level, 0, 0);
+    }
+    half = (int64_t)1 << (level - 1 - WORD_LEVEL);
+    top = partitionTiles(tiles, numOfTiles, true, y + half);
+    topLeft = partitionTiles(tiles, top, false, x + half);
+    bottomLeft = partitionTiles(tiles + top, numOfTiles - top, false, x + half);
+    return findNode(hl,
+                    nodeFromTiles(hl, tiles, topLeft, level - 1, x, y),
+                    nodeFromTiles(hl, tiles + topLeft, top - topLeft, level - 1, x + half, y),
+                    nodeFromTiles(hl, tiles + top, bottomLeft, level - 1, x, y + half),
+                    nodeFromTiles(hl, tiles + top + bottomLeft, numOfTiles - top - bottomLeft, level - 1, x + half, y + half));
+}
+
+// Replace the content of the universe with the tiles
+// (the nodes are built from the tiles, so the memory used depends on the number of tiles
+// and not on the area they are spread over; the order of the tiles is changed)
+void tilesToHashLife(HashLife * hl, HashLifeTile * tiles, int numOfTiles){
+    int64_t minX = 0, minY = 0, maxX = 0, maxY = 0;
+    int level = WORD_LEVEL;
+    if(numOfTiles > 0){
+        minX = maxX = tiles[0].x;
+        minY = maxY = tiles[0].y;
+    }
+    for(int i = 1; i < numOfTiles; i++){
+        minX = tiles[i].x < minX ? tiles[i].x : minX;
+        maxX = tiles[i].x > maxX ? tiles[i].x : maxX;
+        minY = tiles[i].y < minY ? tiles[i].y : minY;
+        maxY = tiles[i].y > maxY ? tiles[i].y : maxY;
+    }
+    while(((int64_t)1 << (level - WORD_LEVEL)) <= maxX - minX || ((int64_t)1 << (level - WORD_LEVEL)) <= maxY - minY){
+        level++;
+    }
+    hl->root = nodeFromTiles(hl, tiles, numOfTiles, level, minX, minY);
+    hl->originX = minX * WORD_BITS;
+    hl->originY = minY * WORD_BITS;
+    hl->generation = 0;
+}
+
+// Advance the universe by 2^exponent generations
+void advanceHashLife(HashLife * hl, int exponent){
+    Node * root;
+    if(exponent != hl->step){
+        clearResults(hl);
+        hl->step = exponent;
+    }
+    // The pattern can grow by 2^exponent cells in each direction,
+    // the root must be large enough to keep it inside the result
+    while(hl->root->level < exponent + 3 ||
+          centeredNode(hl, centeredNode(hl, hl->root))->population != hl->root->population){
+        if(hl->root->level >= MAX_LEVEL){
+            printf("HashLife: the pattern is too large to advance\n");
+            return;
+        }
+        expandRoot(hl);
+    }
+    root = hl->root;
+    hl->root = successor(hl, root);
+    hl->originX += (int64_t)1 << (root->level - 2);
+    hl->originY += (int64_t)1 << (root->level - 2);
+    hl->generation += (uint64_t)1 << exponent;
+
+    if(hl->numOfNodes * sizeof(Node) > hl->memoryLimit){
+        collectGarbage(hl);
+    }
+}
+
+// Mark the node and its descendants as reachable
+static void markNode(Node * n){
+    if(n->marked || n->level == 0){
+        return;
+    }
+    n->marked = true;
+    markNode(n->nw);
+    markNode(n->ne);
+    markNode(n->sw);
+    markNode(n->se);
+}
+
+// Change the rule of the universe (the memoised results of the previous rule are dropped)
+void setHashLifeRule(HashLife * hl, Rule rule){
+    if(!sameRule(hl->rule, rule)){
+        hl->rule = rule;
+        clearResults(hl);
+    }
+}
+
+// Free the blocks that have no nodes in use, and rebuild the free list from the unused nodes of the others
+static void freeEmptyBlocks(HashLife * hl){
+    NodeBlock * block, * next, ** link = &hl->blocks;
+    Node * freeNodes = NULL;
+    bool used;
+    for(block = hl->blocks; block != NULL; block = next){
+        next = block->next;
+        used = false;
+        for(int i = 0; i < NODES_PER_BLOCK && !used; i++){
+            used = block->nodes[i].level >= 0;
+        }
+        if(!used){
+            free(block);
+            hl->numOfBlocks--;
+            continue;
+        }
+        *link = block;
+        link = &block->next;
+        for(int i = NODES_PER_BLOCK - 1; i >= 0; i--){
+            if(block->nodes[i].level < 0){
+                block->nodes[i].next = freeNodes;
+                freeNodes = &block->nodes[i];
+            }
+        }
+    }
+    *link = NULL;
+    hl->freeNodes = freeNodes;
+}
+
+// Free the nodes that are not reachable from the root (or in use by the advance in progress),
+// and give back the blocks that have no nodes left
+// (the memoised results are kept if the result is kept as well)
+void collectGarbage(HashLife * hl){
+    Node * node, * next, ** link;
+    markNode(hl->root);
+    for(size_t i = 0; i < hl->stackSize; i++){
+        markNode(hl->stack[i]);
+    }
+    for(size_t i = 0; i < hl->numOfBuckets; i++){
+        for(node = hl->buckets[i]; node != NULL; node = node->next){
+            if(node->marked && node->result != NULL && !node->result->marked){
+                node->result = NULL;
+            }
+        }
+    }
+    for(size_t i = 0; i < hl->numOfBuckets; i++){
+        link = &hl->buckets[i];
+        for(node = hl->buckets[i]; node != NULL; node = next){
+            next = node->next;
+            if(node->marked){
+                node->marked = false;
+                *link = node;
+                link = &node->next;
+            } else {
+                node->level = -1;
+                hl->numOfNodes--;
+            }
+        }
+        *link = NULL;
+    }
+    freeEmptyBlocks(hl);
+    // If the nodes in use don't fit in the limit, the next collection waits until they double,
+    // so the advance doesn't collect at every step
+    hl->collectLimit = hl->numOfNodes * sizeof(Node) * 2 > hl->memoryLimit ? hl->numOfNodes * sizeof(Node) * 2 : hl->memoryLimit;
+}
+
+// Number of bytes allocated by the universe
+// Return: Size in bytes
+size_t hashLifeSize(const HashLife * hl){
+    return sizeof(HashLife) + hl->numOfBuckets * sizeof(Node *) +
+           hl->numOfBlocks * (sizeof(NodeBlock) + NODES_PER_BLOCK * sizeof(Node));
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "bitmap.h"
+#include "rule.h"
+
+// Node of the quadtree
+// A node of level n is a square of 2^n x 2^n cells. Nodes are canonical:
+// two nodes with the same content are the same node, so the result of a node
+// only has to be calculated once.
+typedef struct Node{
+    struct Node * nw;     // North-west quadrant (NULL on level 0)
+    struct Node * ne;     // North-east quadrant
+    struct Node * sw;     // South-west quadrant
+    struct Node * se;     // South-east quadrant
+    struct Node * result; // Memoised center of the node advanced by the current step (NULL if not calculated)
+    struct Node * next;   // Next node in the same hash bucket (or in the free list)
+    uint64_t population;  // Number of active cells
+    int level;            // Level of the node (0: a single cell, -1: unused node of a block)
+    bool marked;          // Reachable from the root (used by the garbage collector)
+} Node;
+
+// Block of nodes allocated at once
+typedef struct NodeBlock{
+    struct NodeBlock * next; // Next allocated block
+    Node nodes[];            // Nodes of the block
+} NodeBlock;
+
+// Block of 64x64 cells used to build a universe (see tilesToHashLife())
+typedef struct HashLifeTile{
+    int64_t x;              // Column of the tile (cells x*64 ... x*64+63)
+    int64_t y;              // Row of the tile
+    const uint64_t * rows;  // 64 rows of the tile (bit i is the cell in column x*64+i)
+} HashLifeTile;
+
+// HashLife universe
+// The universe is an unbounded plane, the root node covers the area that contains every active cell
+typedef struct HashLife{
+    Node ** buckets;        // Hash table of the canonical nodes
+    size_t numOfBuckets;    // Size of the hash table (power of two)
+    size_t numOfNodes;      // Number of nodes in the hash table
+    NodeBlock * blocks;     // Allocated blocks of nodes
+    size_t numOfBlocks;     // Number of allocated blocks
+    Node * freeNodes;       // Nodes freed by the garbage collector
+    size_t memoryLimit;     // The garbage collector runs when the nodes take more memory (in bytes)
+    size_t collectLimit;    // The garbage collector runs during an advance when the nodes take more memory
+                            // (the memory limit, or twice the nodes in use if they don't fit in it)
+    Node ** stack;          // Nodes in use by the advance in progress (the garbage collector keeps them)
+    size_t stackSize;       // Number of nodes on the stack
+    size_t stackCapacity;   // Size of the stack
+    Node * dead;            // Inactive cell (level 0)
+    Node * alive;           // Active cell (level 0)
+    Node * root;            // Root of the quadtree
+    int64_t originX;        // Position of the north-west corner of the root
+    int64_t originY;
+    int step;               // The memoised results advance the nodes by 2^step generations
+    uint64_t generation;    // Number of generations calculated since the map was loaded
+    Rule rule;              // Rule of the memoised results
+} HashLife;
+
+// Initialize an empty universe
+// memoryLimit: the node cache is collected when it gets larger than this (in bytes)
+// Return: Pointer to the universe
+HashLife * hashlife_init(size_t memoryLimit);
+
+// Frees the memory allocated by the universe
+void hashlife_free(HashLife * hl);
+
+// Replace the content of the universe with the tiles
+// (the nodes are built from the tiles, so the memory used depends on the number of tiles
+// and not on the area they are spread over; the order of the tiles is changed)
+void tilesToHashLife(HashLife * hl, HashLifeTile * tiles, int numOfTiles);
+
+// Advance the universe by 2^exponent generations
+void advanceHashLife(HashLife * hl, int exponent);
+
+// Change the rule of the universe (the memoised results of the previous rule are dropped)
+void setHashLifeRule(HashLife * hl, Rule rule);
+
+// Free the nodes that are not reachable from the root (or in use by the advance in progress),
+// and give back the blocks that have no nodes left
+// (the memoised results are kept if the result is kept as well)
+void collectGarbage(HashLife * hl);
+
+// Number of bytes allocated by the universe
+// Return: Size in bytes
+size_t hashLifeSize(const HashLife * hl);
+
+#endif
\ No newline at end of file
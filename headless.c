@@ -0,0 +1,178 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "headless.h"
+#include "file.h"
+
+// Number of cells calculated in a generation
+// (on the unbounded plane: the cells of the allocated tiles)
+// Return: Number of cells
+static double cellsPerGeneration(Simulation * sim){
+    if(sim->universe != NULL){
+        return (double)sim->universe->numOfTiles * UNIVERSE_TILE_SIZE * UNIVERSE_TILE_SIZE;
+    }
+    return (double)sim->size.width * sim->size.height;
+}
+
+// Write the performance counters of a headless run as a JSON object
+// Return: TRUE on success, FALSE if the file can't be written
+static bool writeStatsFile(Simulation * sim, const char * path, long long generations, long long skipped, double seconds, double cells){
+    FILE * fp = fopen(path, "w");
+    const Stats * stats = &sim->stats;
+    CellStats cellStats = queryCellStats(sim);
+    int x, y, width, height;
+    if(fp == NULL){
+        printf("Error when writing statistics.\n(%s can't be opened)\n", path);
+        return false;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"generations\": %lld,\n", generations);
+    fprintf(fp, "  \"skippedGenerations\": %lld,\n", skipped);
+    fprintf(fp, "  \"seconds\": %.6f,\n", seconds);
+    fprintf(fp, "  \"gensPerSec\": %.1f,\n", seconds > 0 ? (generations - skipped) / seconds : 0.0);
+    fprintf(fp, "  \"cellsPerSec\": %.6g,\n", seconds > 0 ? cells / seconds : 0.0);
+    fprintf(fp, "  \"population\": %lld,\n", cellStats.population);
+    fprintf(fp, "  \"births\": %lld,\n", cellStats.births);
+    fprintf(fp, "  \"deaths\": %lld,\n", cellStats.deaths);
+    fprintf(fp, "  \"calculatedTiles\": %d,\n", cellStats.calculatedTiles);
+    fprintf(fp, "  \"changedTiles\": %d,\n", cellStats.changedTiles);
+    if(populationBounds(sim, &x, &y, &width, &height)){
+        fprintf(fp, "  \"bounds\": {\"x\": %d, \"y\": %d, \"width\": %d, \"height\": %d},\n", x, y, width, height);
+    } else {
+        fprintf(fp, "  \"bounds\": null,\n");
+    }
+    fprintf(fp, "  \"memoryBytes\": %zu,\n", simulationSize(sim));
+    fprintf(fp, "  \"stages\": {\n");
+    fprintf(fp, "    \"step\": {\"runs\": %lld, \"seconds\": %.6f, \"meanMs\": %.6f},\n",
+            stats->step.runs, stats->step.total, stats->step.runs > 0 ? stats->step.total * 1000 / stats->step.runs : 0.0);
+    fprintf(fp, "    \"io\": {\"runs\": %lld, \"seconds\": %.6f, \"meanMs\": %.6f}\n",
+            stats->io.runs, stats->io.total, stats->io.runs > 0 ? stats->io.total * 1000 / stats->io.runs : 0.0);
+    fprintf(fp, "  }\n");
+    fprintf(fp, "}\n");
+    if(fclose(fp) != 0){
+        printf("Error when writing statistics.\n(%s can't be written)\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Write the cell statistics of the current generation as a line of the cell log
+// (after a HashLife jump only the population and the bounds are known)
+static void writeCellLogLine(FILE * fp, Simulation * sim, long long generation, bool stepped){
+    CellStats cellStats = queryCellStats(sim);
+    int x, y, width, height;
+    if(stepped){
+        fprintf(fp, "%lld,%lld,%lld,%lld,%d,", generation, cellStats.population, cellStats.births, cellStats.deaths,
+                cellStats.changedTiles);
+    } else {
+        fprintf(fp, "%lld,%lld,,,,", generation, cellStats.population);
+    }
+    if(populationBounds(sim, &x, &y, &width, &height)){
+        fprintf(fp, "%d,%d,%d,%d\n", x, y, width, height);
+    } else {
+        fprintf(fp, ",,,\n");
+    }
+}
+
+// Load the input map, calculate the given number of generations as fast as possible,
+// save the final state and print the throughput (no window and no simulation thread is used)
+// Return: Exit code of the program
+int runHeadless(Simulation * sim, const Options * options){
+    long long generation = 0;
+    long long jump;
+    long long skipped = 0;
+    double cells = 0;
+    double seconds;
+    Uint64 start, end;
+    FILE * cellLog = NULL;
+    
+    if(!loadMapFile(sim, options->input)){
+        return 1;
+    }
+    if(options->cellLog != NULL){
+        cellLog = fopen(options->cellLog, "w");
+        if(cellLog == NULL){
+            printf("Error when writing the cell log.\n(%s can't be opened)\n", options->cellLog);
+            return 1;
+        }
+        fprintf(cellLog, "generation,population,births,deaths,changedTiles,x,y,width,height\n");
+        writeCellLogLine(cellLog, sim, 0, false);
+    }
+    if(sim->universe != NULL){
+        printf("Loaded %s (unbounded plane)\n", options->input);
+    } else {
+        printf("Loaded %s (%dx%d)\n", options->input, sim->size.width, sim->size.height);
+    }
+    
+    if(sim->hashlife != NULL && sim->universe == NULL){
+        // HashLife simulates an unbounded plane, a jump would ignore the edges of the map
+        printf("HashLife only works on the unbounded plane (--infinite), the map is calculated generation by generation\n");
+    }
+    
+    start = SDL_GetPerformanceCounter();
+    if(sim->hashlife != NULL && sim->universe != NULL && sim->fastForwardExponent < 63){
+        // Jump with HashLife as long as a whole jump fits, the rest is calculated step by step
+        jump = 1LL << sim->fastForwardExponent;
+        while(options->generations - generation >= jump){
+            cells += cellsPerGeneration(sim) * jump;
+            fastForward(sim);
+            generation += jump;
+            if(cellLog != NULL){
+                writeCellLogLine(cellLog, sim, generation, false);
+            }
+        }
+    }
+    while(generation < options->generations){
+        cells += cellsPerGeneration(sim);
+        cycle(sim);
+        generation++;
+        if(cellLog != NULL){
+            // The statistics were gathered by the step, so logging doesn't read the map
+            writeCellLogLine(cellLog, sim, generation, true);
+        }
+        if(sim->periodFound){
+            printPeriod(sim);
+            if(options->onPeriod == period_stop){
+                break;
+            }
+            if(options->onPeriod == period_jump){
+                // The map is the same after every whole period, so they don't have to be calculated
+                skipped = (options->generations - generation) / sim->period->period * sim->period->period;
+                generation += skipped;
+            }
+        }
+    }
+    end = SDL_GetPerformanceCounter();
+    seconds = (double)(end - start) / SDL_GetPerformanceFrequency();
+    if(cellLog != NULL){
+        if(fclose(cellLog) != 0){
+            printf("Error when writing the cell log.\n(%s can't be written)\n", options->cellLog);
+            return 1;
+        }
+        printf("Cell log written to %s\n", options->cellLog);
+    }
+    
+    printf("Generations: %lld\n", generation);
+    if(skipped > 0){
+        printf("Skipped generations: %lld (whole periods)\n", skipped);
+    }
+    printf("Time: %.3f s\n", seconds);
+    if(seconds > 0){
+        // The rates count only the calculated generations
+        printf("Generations/s: %.1f\n", (generation - skipped) / seconds);
+        printf("Cells/s: %.4g\n", cells / seconds);
+    }
+    
+    if(!saveMapFile(sim, options->output)){
+        return 1;
+    }
+    printf("Final state saved to %s\n", options->output);
+    if(options->statsFile != NULL){
+        // Written after saving, so the I/O counters include the output
+        if(!writeStatsFile(sim, options->statsFile, generation, skipped, seconds, cells)){
+            return 1;
+        }
+        printf("Statistics written to %s\n", options->statsFile);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "simulation.h"
+#include "options.h"
+
+// Load the input map, calculate the given number of generations as fast as possible,
+// save the final state and print the throughput (no window and no simulation thread is used)
+// Return: Exit code of the program
+int runHeadless(Simulation * sim, const Options * options);
+
+#endif
\ No newline at end of file
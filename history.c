@@ -0,0 +1,317 @@
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+#include "history.h"
+
+// Largest encoded tile: index, mask of the rows and every row
+#define MAX_ENCODED_TILE (sizeof(uint32_t) + sizeof(uint64_t) + TILE_ROWS * sizeof(uint64_t))
+
+// Initial size of the data of a record (it grows while the tiles are encoded)
+#define INITIAL_RECORD_SIZE 4096
+
+// Initialize an empty history
+// budget: memory limit of the records (in bytes)
+// Return: Pointer to the history
+History * history_init(size_t budget){
+    History * h = calloc(1, sizeof(History));
+    if(h == NULL){
+        notEnoughMemory();
+    }
+    h->budget = budget;
+    return h;
+}
+
+// Get a record by its position (0: the oldest record)
+// Return: Pointer to the record
+static HistoryRecord * recordAt(const History * h, int i){
+    return h->records[(h->first + i) % h->capacity];
+}
+
+// Drop the oldest record
+static void dropOldest(History * h){
+    HistoryRecord * record = recordAt(h, 0);
+    h->size -= sizeof(HistoryRecord) + record->size;
+    free(record);
+    h->first = (h->first + 1) % h->capacity;
+    h->count--;
+}
+
+// Drop the newest record
+static void dropNewest(History * h){
+    HistoryRecord * record = recordAt(h, h->count - 1);
+    h->size -= sizeof(HistoryRecord) + record->size;
+    free(record);
+    h->count--;
+}
+
+// Drop every record (the generation counter is kept)
+void clearHistory(History * h){
+    while(h->count > 0){
+        dropNewest(h);
+    }
+    h->first = 0;
+    h->latest = h->generation;
+}
+
+// Frees the memory allocated by the history
+void history_free(History * h){
+    if(h == NULL){
+        return;
+    }
+    clearHistory(h);
+    free(h->records);
+    free(h);
+}
+
+// Append a record, the oldest records are dropped to stay within the budget
+static void appendRecord(History * h, HistoryRecord * record){
+    HistoryRecord ** records;
+    if(h->count == h->capacity){
+        // Grow the ring buffer and move the records to its beginning
+        records = malloc((h->capacity == 0 ? 256 : h->capacity * 2) * sizeof(HistoryRecord *));
+        if(records == NULL){
+            notEnoughMemory();
+        }
+        for(int i = 0; i < h->count; i++){
+            records[i] = recordAt(h, i);
+        }
+        free(h->records);
+        h->records = records;
+        h->capacity = h->capacity == 0 ? 256 : h->capacity * 2;
+        h->first = 0;
+    }
+    h->records[(h->first + h->count) % h->capacity] = record;
+    h->count++;
+    h->size += sizeof(HistoryRecord) + record->size;
+    while(h->size > h->budget && h->count > 1){
+        dropOldest(h);
+    }
+}
+
+// Encode a tile (only if it has a non-zero row)
+// words: the word of the tile in each row
+// Return: Number of bytes written
+static size_t encodeTile(uint8_t * data, uint32_t tile, const uint64_t words[TILE_ROWS]){
+    uint64_t mask = 0;
+    size_t size = sizeof(tile) + sizeof(mask);
+    for(int r = 0; r < TILE_ROWS; r++){
+        if(words[r] != 0){
+            mask |= (uint64_t)1 << r;
+            memcpy(data + size, &words[r], sizeof(uint64_t));
+            size += sizeof(uint64_t);
+        }
+    }
+    if(mask == 0){
+        return 0;
+    }
+    memcpy(data, &tile, sizeof(tile));
+    memcpy(data + sizeof(tile), &mask, sizeof(mask));
+    return size;
+}
+
+// Grow the data of a record, so another tile fits in it
+// (the capacity is never larger than needed for a record of the given limit)
+// Return: Pointer to the record (it may be moved)
+static HistoryRecord * growRecord(HistoryRecord * record, size_t * capacity, size_t limit){
+    *capacity *= 2;
+    if(*capacity > limit + MAX_ENCODED_TILE){
+        *capacity = limit + MAX_ENCODED_TILE;
+    }
+    record = realloc(record, sizeof(HistoryRecord) + *capacity);
+    if(record == NULL){
+        notEnoughMemory();
+    }
+    return record;
+}
+
+// Create a record from the tiles of the map
+// previous: XOR the tiles with this map (NULL: keyframe, the tiles are stored as they are)
+// changed: only these tiles are stored (NULL: every tile)
+// limit: largest size of the record (in bytes), the encoding stops when the record gets larger
+// Return: Pointer to the record, or NULL if it would be larger than the limit
+static HistoryRecord * createRecord(long long generation, const Bitmap * previous, const Bitmap * map,
+                                    const uint8_t * changed, int columns, int rows, size_t limit){
+    uint64_t words[TILE_ROWS];
+    size_t size = 0, capacity = INITIAL_RECORD_SIZE;
+    HistoryRecord * record;
+    int y;
+
+    if(sizeof(HistoryRecord) > limit){
+        return NULL;
+    }
+    record = malloc(sizeof(HistoryRecord) + capacity);
+    if(record == NULL){
+        notEnoughMemory();
+    }
+    for(int ty = 0; ty < rows; ty++){
+        for(int tx = 0; tx < columns; tx++){
+            if(changed != NULL && !changed[(size_t)ty * columns + tx]){
+                continue;
+            }
+            for(int r = 0; r < TILE_ROWS; r++){
+                y = ty * TILE_ROWS + r;
+                words[r] = y < map->height ? mapRow(map, y)[tx] : 0;
+                if(previous != NULL && y < map->height){
+                    words[r] ^= mapRow(previous, y)[tx];
+                }
+            }
+            if(size + MAX_ENCODED_TILE > capacity){
+                record = growRecord(record, &capacity, limit);
+            }
+            size += encodeTile(record->data + size, (uint32_t)((size_t)ty * columns + tx), words);
+            if(sizeof(HistoryRecord) + size > limit){
+                free(record);
+                return NULL;
+            }
+        }
+    }
+    // Give back the unused space
+    record = realloc(record, sizeof(HistoryRecord) + size);
+    if(record == NULL){
+        notEnoughMemory();
+    }
+    record->generation = generation;
+    record->keyframe = previous == NULL;
+    record->size = size;
+    return record;
+}
+
+// Record the next generation of the map
+// previous, next: the current and the next state of the map
+// changed: flags of the tiles that are different on the two maps
+// (the recorded generations after the current one are dropped first)
+void recordGeneration(History * h, const Bitmap * previous, const Bitmap * next,
+                      const uint8_t * changed, int columns, int rows){
+    HistoryRecord * delta, * keyframe;
+    // A new generation after a step back starts a new timeline
+    while(h->count > 0 && recordAt(h, h->count - 1)->generation > h->generation){
+        dropNewest(h);
+    }
+    h->generation++;
+    h->latest = h->generation;
+    delta = createRecord(h->generation, previous, next, changed, columns, rows, h->budget);
+    if(delta == NULL){
+        // The generation can't be recorded, so the earlier ones can't be reached from the map either
+        clearHistory(h);
+        return;
+    }
+    appendRecord(h, delta);
+    if(h->generation % HISTORY_KEYFRAME_INTERVAL == 0){
+        // A keyframe that takes most of the budget would push out the deltas, so it is skipped
+        keyframe = createRecord(h->generation, NULL, next, NULL, columns, rows, h->budget / 4);
+        if(keyframe != NULL){
+            appendRecord(h, keyframe);
+        }
+    }
+}
+
+// Get the oldest generation the map can be moved to
+// Return: Generation
+long long oldestGeneration(const History * h){
+    const HistoryRecord * oldest;
+    if(h->count == 0){
+        return h->generation;
+    }
+    oldest = recordAt(h, 0);
+    return oldest->keyframe ? oldest->generation : oldest->generation - 1;
+}
+
+// Find a record of a generation
+// Return: Position of the record, or -1 if it is not in the history
+static int findRecord(const History * h, long long generation, bool keyframe){
+    int low = 0, high = h->count - 1, middle;
+    const HistoryRecord * record;
+    // The records are ordered by generation, and the delta of a generation comes before its keyframe
+    while(low <= high){
+        middle = (low + high) / 2;
+        record = recordAt(h, middle);
+        if(record->generation < generation || (record->generation == generation && record->keyframe < keyframe)){
+            low = middle + 1;
+        } else if(record->generation > generation || record->keyframe > keyframe){
+            high = middle - 1;
+        } else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+// Apply a record to the map: XOR the tiles of a delta, or write the tiles of a keyframe on an empty map
+static void applyRecord(const HistoryRecord * record, Bitmap * map, Checkpoints * cp,
+                        uint8_t * changed, uint8_t * dirty, int columns){
+    size_t i = 0;
+    uint32_t tile;
+    uint64_t mask, word;
+    int tx, ty, y;
+    while(i < record->size){
+        memcpy(&tile, record->data + i, sizeof(tile));
+        memcpy(&mask, record->data + i + sizeof(tile), sizeof(mask));
+        i += sizeof(tile) + sizeof(mask);
+        tx = (int)(tile % columns);
+        ty = (int)(tile / columns);
+        preserveTile(cp, map, tx, ty);
+        for(; mask != 0; mask &= mask - 1){
+            y = ty * TILE_ROWS + __builtin_ctzll(mask);
+            memcpy(&word, record->data + i, sizeof(word));
+            i += sizeof(word);
+            mapRow(map, y)[tx] ^= word;
+        }
+        changed[tile] = 1;
+        dirty[tile] = 1;
+    }
+}
+
+// Move the map to another recorded generation
+// The tiles are saved for the checkpoints before they are modified, and flagged as changed and dirty.
+// Return: TRUE on success, FALSE if the generation is not in the history
+bool seekHistory(History * h, long long generation, Bitmap * map, Checkpoints * cp,
+                 uint8_t * changed, uint8_t * dirty, int columns, int rows){
+    int keyframe = -1, index;
+    if(generation < oldestGeneration(h) || generation > h->latest){
+        return false;
+    }
+    // Start from the keyframe between the target and the current generation that is closest to the target
+    for(int i = 0; i < h->count; i++){
+        const HistoryRecord * record = recordAt(h, i);
+        if(!record->keyframe){
+            continue;
+        }
+        if(generation < h->generation ? (record->generation >= generation && record->generation < h->generation &&
+                                         (keyframe < 0 || record->generation < recordAt(h, keyframe)->generation))
+                                      : (record->generation <= generation && record->generation > h->generation &&
+                                         (keyframe < 0 || record->generation > recordAt(h, keyframe)->generation))){
+            keyframe = i;
+        }
+    }
+    if(keyframe >= 0){
+        preserveAllTiles(cp, map);
+        clearMap(map);
+        applyRecord(recordAt(h, keyframe), map, cp, changed, dirty, columns);
+        h->generation = recordAt(h, keyframe)->generation;
+        // Every tile may have changed, not only the tiles of the keyframe
+        memset(changed, 1, (size_t)columns * rows);
+        memset(dirty, 1, (size_t)columns * rows);
+    }
+    // The delta of a generation moves the map between it and the previous generation in both directions
+    while(h->generation > generation){
+        if((index = findRecord(h, h->generation, false)) < 0){
+            return false;
+        }
+        applyRecord(recordAt(h, index), map, cp, changed, dirty, columns);
+        h->generation--;
+    }
+    while(h->generation < generation){
+        if((index = findRecord(h, h->generation + 1, false)) < 0){
+            return false;
+        }
+        applyRecord(recordAt(h, index), map, cp, changed, dirty, columns);
+        h->generation++;
+    }
+    return true;
+}
+
+// Number of bytes allocated by the history
+// Return: Size in bytes
+size_t historySize(const History * h){
+    return sizeof(History) + h->capacity * sizeof(HistoryRecord *) + h->size;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "bitmap.h"
+#include "checkpoint.h"
+
+// A keyframe is recorded after every HISTORY_KEYFRAME_INTERVAL generations
+#define HISTORY_KEYFRAME_INTERVAL 1024
+
+// Recorded change of the map
+// The tiles are stored one after the other: the index of the tile (uint32_t), a mask of its
+// non-zero rows (uint64_t) and the non-zero words of the rows, so the empty rows take no space.
+typedef struct HistoryRecord{
+    long long generation;   // Delta: the XOR of the generations generation - 1 and generation,
+                            // keyframe: the state of the generation
+    bool keyframe;          // The record is a keyframe
+    size_t size;            // Size of the data (in bytes)
+    uint8_t data[];         // Encoded tiles
+} HistoryRecord;
+
+// History of the last generations of a map within a memory budget
+// Every generation records the XOR delta of the tiles that changed. A delta is its own inverse,
+// so the map can step backward and forward through the deltas. Keyframes let a jump to
+// a far generation start from a nearby full state. The oldest records are dropped
+// when the records take more memory than the budget.
+typedef struct History{
+    HistoryRecord ** records; // Ring buffer of the records in the order of the generations
+    int capacity;             // Size of the ring buffer
+    int first;                // Position of the oldest record
+    int count;                // Number of records
+    size_t size;              // Memory used by the records (in bytes)
+    size_t budget;            // Memory limit of the records (in bytes)
+    long long generation;     // Generation of the map
+    long long latest;         // Latest recorded generation (after a step back it is larger than generation)
+} History;
+
+// Initialize an empty history
+// budget: memory limit of the records (in bytes)
+// Return: Pointer to the history
+History * history_init(size_t budget);
+
+// Frees the memory allocated by the history
+void history_free(History * h);
+
+// Drop every record (the generation counter is kept)
+void clearHistory(History * h);
+
+// Record the next generation of the map
+// previous, next: the current and the next state of the map
+// changed: flags of the tiles that are different on the two maps
+// (the recorded generations after the current one are dropped first)
+void recordGeneration(History * h, const Bitmap * previous, const Bitmap * next,
+                      const uint8_t * changed, int columns, int rows);
+
+// Get the oldest generation the map can be moved to
+// Return: Generation
+long long oldestGeneration(const History * h);
+
+// Move the map to another recorded generation
+// The tiles are saved for the checkpoints before they are modified, and flagged as changed and dirty.
+// Return: TRUE on success, FALSE if the generation is not in the history
+bool seekHistory(History * h, long long generation, Bitmap * map, Checkpoints * cp,
+                 uint8_t * changed, uint8_t * dirty, int columns, int rows);
+
+// Number of bytes allocated by the history
+// Return: Size in bytes
+size_t historySize(const History * h);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include <string.h>
+#include "kernel.h"
+
+// The vectorized kernels are compiled for x86 processors with GCC,
+// the processor is checked with cpuid at runtime before they are used
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// Names of the kernels (in the order of step_kernel)
+static const char * kernelNames[] = {
+    "scalar",
+    "bitwise",
+    "avx2",
+    "avx512"
+};
+
+// Name of the kernel (used in command line options and log messages)
+// Return: Name of the kernel
+const char * kernelName(step_kernel kernel){
+    return kernelNames[kernel];
+}
+
+// Find the kernel by its name
+// Return: TRUE if the name is valid, FALSE otherwise
+bool parseKernelName(const char * name, step_kernel * kernel){
+    for(int i = 0; i < (int)(sizeof(kernelNames) / sizeof(kernelNames[0])); i++){
+        if(strcmp(name, kernelNames[i]) == 0){
+            *kernel = (step_kernel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Multiplexer of the rule tree: f0 where v is 0, f1 where v is 1
+#define RULE_MUX(v, f0, f1) ((f0) ^ ((v) & ((f0) ^ (f1))))
+
+// Leaf of the rule tree: the next state of the cells with n neighbours
+// (the masks of the rule are turned into all zero or all one words)
+#define RULE_LEAF(c, birth, survival, n) \
+    (((c) & -(long long)(((survival) >> (n)) & 1)) | (~(c) & -(long long)(((birth) >> (n)) & 1)))
+
+// Define a function that calculates the next state of the cells of a rule from their neighbour counts
+// The leaves of the tree are selected by the bits of the count (s3 is only set with 8 neighbours,
+// then the other bits are 0). With constant masks the compiler merges the equal leaves,
+// so a specialized kernel only calculates what its rule needs.
+#define DEFINE_APPLY_RULE(name, type, target) \
+target __attribute__((always_inline)) \
+static inline type name(type s0, type s1, type s2, type s3, type c, uint16_t birth, uint16_t survival){ \
+    type l0 = RULE_LEAF(c, birth, survival, 0), l1 = RULE_LEAF(c, birth, survival, 1); \
+    type l2 = RULE_LEAF(c, birth, survival, 2), l3 = RULE_LEAF(c, birth, survival, 3); \
+    type l4 = RULE_LEAF(c, birth, survival, 4), l5 = RULE_LEAF(c, birth, survival, 5); \
+    type l6 = RULE_LEAF(c, birth, survival, 6), l7 = RULE_LEAF(c, birth, survival, 7); \
+    type l8 = RULE_LEAF(c, birth, survival, 8); \
+    type low = RULE_MUX(s1, RULE_MUX(s0, l0, l1), RULE_MUX(s0, l2, l3)); \
+    type high = RULE_MUX(s1, RULE_MUX(s0, l4, l5), RULE_MUX(s0, l6, l7)); \
+    return RULE_MUX(s3, RULE_MUX(s2, low, high), l8); \
+}
+
+DEFINE_APPLY_RULE(applyRule, uint64_t, )
+
+// Count the neighbours of the cells of the i-th word of a row
+// Every bit position holds a separate counter, the neighbours are summed up
+// with full and half adders into a 4 bit number (s0: ones, s1: twos, s2: fours, s3: eights)
+// c: current state of the cells
+static inline void countWord(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i,
+                             uint64_t * s0, uint64_t * s1, uint64_t * s2, uint64_t * s3, uint64_t * c){
+    uint64_t a, aw, ae, cw, ce, b, bw, be;
+    uint64_t t0, t1, m0, m1, b0, b1, c1, x0, x1;
+
+    // Neighbours to the west are shifted up, neighbours to the east are shifted down
+    a  = above[i];
+    aw = (a << 1) | (above[i - 1] >> 63);
+    ae = (a >> 1) | (above[i + 1] << 63);
+    *c = row[i];
+    cw = (*c << 1) | (row[i - 1] >> 63);
+    ce = (*c >> 1) | (row[i + 1] << 63);
+    b  = below[i];
+    bw = (b << 1) | (below[i - 1] >> 63);
+    be = (b >> 1) | (below[i + 1] << 63);
+
+    // Row above (0-3)
+    t0 = aw ^ a ^ ae;
+    t1 = (aw & a) | (ae & (aw ^ a));
+    // Left and right neighbours (0-2)
+    m0 = cw ^ ce;
+    m1 = cw & ce;
+    // Row below (0-3)
+    b0 = bw ^ b ^ be;
+    b1 = (bw & b) | (be & (bw ^ b));
+    // Ones
+    *s0 = t0 ^ m0 ^ b0;
+    c1 = (t0 & m0) | (b0 & (t0 ^ m0));
+    // Twos, fours and eights
+    x0 = t1 ^ m1 ^ b1;
+    x1 = (t1 & m1) | (b1 & (t1 ^ m1));
+    *s1 = x0 ^ c1;
+    *s2 = x1 ^ (x0 & c1);
+    *s3 = x1 & x0 & c1;
+}
+
+// Calculate the next state of the i-th word of a row with Conway's rule
+// (the eights are not needed: 8 neighbours look like 0, which is still a dead cell)
+// Return: Next state of the word
+static inline uint64_t lifeWord(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i){
+    uint64_t s0, s1, s2, s3, c;
+    countWord(above, row, below, i, &s0, &s1, &s2, &s3, &c);
+    // Alive with 3 neighbours, or with 2 neighbours if it was already alive
+    return s1 & ~s2 & (s0 | c);
+}
+
+// Calculate the next state of the i-th word of a row with the given rule
+// Return: Next state of the word
+__attribute__((always_inline))
+static inline uint64_t ruleWord(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i,
+                                uint16_t birth, uint16_t survival){
+    uint64_t s0, s1, s2, s3, c;
+    countWord(above, row, below, i, &s0, &s1, &s2, &s3, &c);
+    return applyRule(s0, s1, s2, s3, c, birth, survival);
+}
+
+// Calculate the next state of the words [first, last) of a row with bitwise operations (Conway's rule)
+static void stepWordsBitwise(const uint64_t * above, const uint64_t * row, const uint64_t * below,
+                             uint64_t * next, int first, int last, Rule rule){
+    (void)rule;
+    for(int i = first; i < last; i++){
+        next[i] = lifeWord(above, row, below, i);
+    }
+}
+
+#ifdef KERNEL_X86
+
+// Same as countWord() on 4 consecutive words
+__attribute__((target("avx2")))
+static inline void countWordAvx2(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i,
+                                 __m256i * s0, __m256i * s1, __m256i * s2, __m256i * s3, __m256i * c){
+    __m256i a, aw, ae, cw, ce, b, bw, be;
+    __m256i t0, t1, m0, m1, b0, b1, c1, x0, x1;
+
+    a  = _mm256_loadu_si256((const __m256i *)(above + i));
+    aw = _mm256_or_si256(_mm256_slli_epi64(a, 1), _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *)(above + i - 1)), 63));
+    ae = _mm256_or_si256(_mm256_srli_epi64(a, 1), _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *)(above + i + 1)), 63));
+    *c = _mm256_loadu_si256((const __m256i *)(row + i));
+    cw = _mm256_or_si256(_mm256_slli_epi64(*c, 1), _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *)(row + i - 1)), 63));
+    ce = _mm256_or_si256(_mm256_srli_epi64(*c, 1), _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *)(row + i + 1)), 63));
+    b  = _mm256_loadu_si256((const __m256i *)(below + i));
+    bw = _mm256_or_si256(_mm256_slli_epi64(b, 1), _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *)(below + i - 1)), 63));
+    be = _mm256_or_si256(_mm256_srli_epi64(b, 1), _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *)(below + i + 1)), 63));
+
+    t0 = _mm256_xor_si256(_mm256_xor_si256(aw, a), ae);
+    t1 = _mm256_or_si256(_mm256_and_si256(aw, a), _mm256_and_si256(ae, _mm256_xor_si256(aw, a)));
+    m0 = _mm256_xor_si256(cw, ce);
+    m1 = _mm256_and_si256(cw, ce);
+    b0 = _mm256_xor_si256(_mm256_xor_si256(bw, b), be);
+    b1 = _mm256_or_si256(_mm256_and_si256(bw, b), _mm256_and_si256(be, _mm256_xor_si256(bw, b)));
+    *s0 = _mm256_xor_si256(_mm256_xor_si256(t0, m0), b0);
+    c1 = _mm256_or_si256(_mm256_and_si256(t0, m0), _mm256_and_si256(b0, _mm256_xor_si256(t0, m0)));
+    x0 = _mm256_xor_si256(_mm256_xor_si256(t1, m1), b1);
+    x1 = _mm256_or_si256(_mm256_and_si256(t1, m1), _mm256_and_si256(b1, _mm256_xor_si256(t1, m1)));
+    *s1 = _mm256_xor_si256(x0, c1);
+    *s2 = _mm256_xor_si256(x1, _mm256_and_si256(x0, c1));
+    *s3 = _mm256_and_si256(x1, _mm256_and_si256(x0, c1));
+}
+
+// Same as lifeWord() on 4 consecutive words
+__attribute__((target("avx2")))
+static inline __m256i lifeWordAvx2(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i){
+    __m256i s0, s1, s2, s3, c;
+    countWordAvx2(above, row, below, i, &s0, &s1, &s2, &s3, &c);
+    return _mm256_and_si256(_mm256_andnot_si256(s2, s1), _mm256_or_si256(s0, c));
+}
+
+DEFINE_APPLY_RULE(applyRuleAvx2, __m256i, __attribute__((target("avx2"))))
+
+// Same as ruleWord() on 4 consecutive words
+__attribute__((target("avx2"), always_inline))
+static inline __m256i ruleWordAvx2(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i,
+                                   uint16_t birth, uint16_t survival){
+    __m256i s0, s1, s2, s3, c;
+    countWordAvx2(above, row, below, i, &s0, &s1, &s2, &s3, &c);
+    return applyRuleAvx2(s0, s1, s2, s3, c, birth, survival);
+}
+
+// Calculate the next state of the words [first, last) of a row with AVX2 instructions (Conway's rule)
+__attribute__((target("avx2")))
+static void stepWordsAvx2(const uint64_t * above, const uint64_t * row, const uint64_t * below,
+                          uint64_t * next, int first, int last, Rule rule){
+    int i = first;
+    (void)rule;
+    for(; i + 4 <= last; i += 4){
+        _mm256_storeu_si256((__m256i *)(next + i), lifeWordAvx2(above, row, below, i));
+    }
+    for(; i < last; i++){
+        next[i] = lifeWord(above, row, below, i);
+    }
+}
+
+// Ternary logic functions (truth tables of the inputs a, b, c)
+#define TERN_XOR3     0x96 // a ^ b ^ c
+#define TERN_MAJORITY 0xE8 // (a & b) | (c & (a ^ b))
+#define TERN_AND3     0x80 // a & b & c
+#define TERN_LIFE     0x20 // a & ~b & c
+
+// Same as countWord() on 8 consecutive words
+__attribute__((target("avx512f")))
+static inline void countWordAvx512(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i,
+                                   __m512i * s0, __m512i * s1, __m512i * s2, __m512i * s3, __m512i * c){
+    __m512i a, aw, ae, cw, ce, b, bw, be;
+    __m512i t0, t1, m0, m1, b0, b1, c1, x0, x1;
+
+    a  = _mm512_loadu_si512((const void *)(above + i));
+    aw = _mm512_or_si512(_mm512_slli_epi64(a, 1), _mm512_srli_epi64(_mm512_loadu_si512((const void *)(above + i - 1)), 63));
+    ae = _mm512_or_si512(_mm512_srli_epi64(a, 1), _mm512_slli_epi64(_mm512_loadu_si512((const void *)(above + i + 1)), 63));
+    *c = _mm512_loadu_si512((const void *)(row + i));
+    cw = _mm512_or_si512(_mm512_slli_epi64(*c, 1), _mm512_srli_epi64(_mm512_loadu_si512((const void *)(row + i - 1)), 63));
+    ce = _mm512_or_si512(_mm512_srli_epi64(*c, 1), _mm512_slli_epi64(_mm512_loadu_si512((const void *)(row + i + 1)), 63));
+    b  = _mm512_loadu_si512((const void *)(below + i));
+    bw = _mm512_or_si512(_mm512_slli_epi64(b, 1), _mm512_srli_epi64(_mm512_loadu_si512((const void *)(below + i - 1)), 63));
+    be = _mm512_or_si512(_mm512_srli_epi64(b, 1), _mm512_slli_epi64(_mm512_loadu_si512((const void *)(below + i + 1)), 63));
+
+    t0 = _mm512_ternarylogic_epi64(aw, a, ae, TERN_XOR3);
+    t1 = _mm512_ternarylogic_epi64(aw, a, ae, TERN_MAJORITY);
+    m0 = _mm512_xor_si512(cw, ce);
+    m1 = _mm512_and_si512(cw, ce);
+    b0 = _mm512_ternarylogic_epi64(bw, b, be, TERN_XOR3);
+    b1 = _mm512_ternarylogic_epi64(bw, b, be, TERN_MAJORITY);
+    *s0 = _mm512_ternarylogic_epi64(t0, m0, b0, TERN_XOR3);
+    c1 = _mm512_ternarylogic_epi64(t0, m0, b0, TERN_MAJORITY);
+    x0 = _mm512_ternarylogic_epi64(t1, m1, b1, TERN_XOR3);
+    x1 = _mm512_ternarylogic_epi64(t1, m1, b1, TERN_MAJORITY);
+    *s1 = _mm512_xor_si512(x0, c1);
+    *s2 = _mm512_xor_si512(x1, _mm512_and_si512(x0, c1));
+    *s3 = _mm512_ternarylogic_epi64(x1, x0, c1, TERN_AND3);
+}
+
+// Same as lifeWord() on 8 consecutive words
+__attribute__((target("avx512f")))
+static inline __m512i lifeWordAvx512(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i){
+    __m512i s0, s1, s2, s3, c;
+    countWordAvx512(above, row, below, i, &s0, &s1, &s2, &s3, &c);
+    return _mm512_ternarylogic_epi64(s1, s2, _mm512_or_si512(s0, c), TERN_LIFE);
+}
+
+DEFINE_APPLY_RULE(applyRuleAvx512, __m512i, __attribute__((target("avx512f"))))
+
+// Same as ruleWord() on 8 consecutive words
+__attribute__((target("avx512f"), always_inline))
+static inline __m512i ruleWordAvx512(const uint64_t * above, const uint64_t * row, const uint64_t * below, int i,
+                                     uint16_t birth, uint16_t survival){
+    __m512i s0, s1, s2, s3, c;
+    countWordAvx512(above, row, below, i, &s0, &s1, &s2, &s3, &c);
+    return applyRuleAvx512(s0, s1, s2, s3, c, birth, survival);
+}
+
+// Calculate the next state of the words [first, last) of a row with AVX-512 instructions (Conway's rule)
+__attribute__((target("avx512f")))
+static void stepWordsAvx512(const uint64_t * above, const uint64_t * row, const uint64_t * below,
+                            uint64_t * next, int first, int last, Rule rule){
+    int i = first;
+    (void)rule;
+    for(; i + 8 <= last; i += 8){
+        _mm512_storeu_si512((void *)(next + i), lifeWordAvx512(above, row, below, i));
+    }
+    for(; i < last; i++){
+        next[i] = lifeWord(above, row, below, i);
+    }
+}
+
+// Define the AVX2 and AVX-512 kernels of a rule (see DEFINE_RULE_KERNELS())
+#define DEFINE_RULE_KERNELS_X86(name, birth, survival) \
+__attribute__((target("avx2"))) \
+static void stepWords##name##Avx2(const uint64_t * above, const uint64_t * row, const uint64_t * below, \
+                                  uint64_t * next, int first, int last, Rule rule){ \
+    int i = first; \
+    (void)rule; \
+    for(; i + 4 <= last; i += 4){ \
+        _mm256_storeu_si256((__m256i *)(next + i), ruleWordAvx2(above, row, below, i, birth, survival)); \
+    } \
+    for(; i < last; i++){ \
+        next[i] = ruleWord(above, row, below, i, birth, survival); \
+    } \
+} \
+__attribute__((target("avx512f"))) \
+static void stepWords##name##Avx512(const uint64_t * above, const uint64_t * row, const uint64_t * below, \
+                                    uint64_t * next, int first, int last, Rule rule){ \
+    int i = first; \
+    (void)rule; \
+    for(; i + 8 <= last; i += 8){ \
+        _mm512_storeu_si512((void *)(next + i), ruleWordAvx512(above, row, below, i, birth, survival)); \
+    } \
+    for(; i < last; i++){ \
+        next[i] = ruleWord(above, row, below, i, birth, survival); \
+    } \
+}
+
+#else
+
+#define DEFINE_RULE_KERNELS_X86(name, birth, survival)
+
+#endif
+
+// Define the kernels of a rule on every instruction set
+// birth, survival: masks of the rule (constants for a specialized kernel,
+// rule.birth and rule.survival for the generic kernel that reads them at runtime)
+#define DEFINE_RULE_KERNELS(name, birth, survival) \
+static void stepWords##name##Bitwise(const uint64_t * above, const uint64_t * row, const uint64_t * below, \
+                                     uint64_t * next, int first, int last, Rule rule){ \
+    (void)rule; \
+    for(int i = first; i < last; i++){ \
+        next[i] = ruleWord(above, row, below, i, birth, survival); \
+    } \
+} \
+DEFINE_RULE_KERNELS_X86(name, birth, survival)
+
+// Neighbour counts (bit n: n neighbours)
+#define N(n) (1 << (n))
+
+DEFINE_RULE_KERNELS(HighLife, N(3) | N(6), N(2) | N(3))
+DEFINE_RULE_KERNELS(DayAndNight, N(3) | N(6) | N(7) | N(8), N(3) | N(4) | N(6) | N(7) | N(8))
+DEFINE_RULE_KERNELS(Seeds, N(2), 0)
+DEFINE_RULE_KERNELS(Generic, rule.birth, rule.survival)
+
+// Rules with specialized kernels (in the order of the kernel tables, the other rules use the generic kernels)
+static const Rule specializedRules[] = {
+    {N(3), N(2) | N(3)},                                            // Conway's Game of Life
+    {N(3) | N(6), N(2) | N(3)},                                     // HighLife
+    {N(3) | N(6) | N(7) | N(8), N(3) | N(4) | N(6) | N(7) | N(8)}, // Day & Night
+    {N(2), 0}                                                       // Seeds
+};
+
+// Number of rules with specialized kernels
+#define NUM_OF_SPECIALIZED_RULES ((int)(sizeof(specializedRules) / sizeof(specializedRules[0])))
+
+// Kernels of the rules (the last one is the generic kernel)
+static const word_kernel bitwiseKernels[] = {
+    stepWordsBitwise, stepWordsHighLifeBitwise, stepWordsDayAndNightBitwise, stepWordsSeedsBitwise, stepWordsGenericBitwise
+};
+#ifdef KERNEL_X86
+static const word_kernel avx2Kernels[] = {
+    stepWordsAvx2, stepWordsHighLifeAvx2, stepWordsDayAndNightAvx2, stepWordsSeedsAvx2, stepWordsGenericAvx2
+};
+static const word_kernel avx512Kernels[] = {
+    stepWordsAvx512, stepWordsHighLifeAvx512, stepWordsDayAndNightAvx512, stepWordsSeedsAvx512, stepWordsGenericAvx512
+};
+#endif
+
+#undef N
+
+// Checks if the processor can run the kernel
+// Return: TRUE if the kernel is supported, FALSE otherwise
+bool kernelSupported(step_kernel kernel){
+    switch(kernel){
+        case kernel_scalar:
+        case kernel_bitwise:
+            return true;
+#ifdef KERNEL_X86
+        case kernel_avx2:
+            return __builtin_cpu_supports("avx2");
+        case kernel_avx512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+// Select the fastest kernel the processor supports
+// Return: step_kernel
+step_kernel bestKernel(){
+    if(kernelSupported(kernel_avx512)){
+        return kernel_avx512;
+    }
+    if(kernelSupported(kernel_avx2)){
+        return kernel_avx2;
+    }
+    return kernel_bitwise;
+}
+
+// Find the specialized kernels of the rule
+// Return: Position in the kernel tables (NUM_OF_SPECIALIZED_RULES: the generic kernel)
+static int ruleKernelIndex(Rule rule){
+    int i = 0;
+    while(i < NUM_OF_SPECIALIZED_RULES && !sameRule(rule, specializedRules[i])){
+        i++;
+    }
+    return i;
+}
+
+// Checks if the rule has its own kernels, or it is calculated by the generic kernel
+// Return: TRUE if the rule has specialized kernels, FALSE otherwise
+bool specializedRule(Rule rule){
+    return ruleKernelIndex(rule) < NUM_OF_SPECIALIZED_RULES;
+}
+
+// Get the word kernel of a kernel that works on whole words
+// Rules with specialized kernels are calculated by them, the other rules by the generic kernel
+// Return: Function pointer, or NULL for the scalar kernel
+word_kernel wordKernel(step_kernel kernel, Rule rule){
+    switch(kernel){
+        case kernel_bitwise:
+            return bitwiseKernels[ruleKernelIndex(rule)];
+#ifdef KERNEL_X86
+        case kernel_avx2:
+            return avx2Kernels[ruleKernelIndex(rule)];
+        case kernel_avx512:
+            return avx512Kernels[ruleKernelIndex(rule)];
+#endif
+        default:
+            return NULL;
+    }
+}
+
+// Add the statistics of a word to the counters (see stats_kernel)
+// The births and the deaths are the bits that differ between the two states, so a word takes two popcounts.
+__attribute__((always_inline))
+static inline void countStats(uint64_t old, uint64_t word, TileCounters * counters, int i, int row){
+    counters->births[i] += __builtin_popcountll(word & ~old);
+    counters->deaths[i] += __builtin_popcountll(old & ~word);
+    counters->columns[i] |= word;
+    counters->rows[i] |= (uint64_t)(word != 0) << row;
+}
+
+// Gather the statistics of the words of a calculated row (see stats_kernel)
+static void gatherStats(const uint64_t * current, const uint64_t * next, TileCounters * counters,
+                        int row, int first, int last, uint64_t lastMask){
+    for(int i = first; i < last - 1; i++){
+        countStats(current[i], next[i], counters, i - first, row);
+    }
+    countStats(current[last - 1] & lastMask, next[last - 1], counters, last - 1 - first, row);
+}
+
+#ifdef KERNEL_X86
+// Gather the statistics of the words of a calculated row with the popcnt instruction
+__attribute__((target("popcnt")))
+static void gatherStatsPopcnt(const uint64_t * current, const uint64_t * next, TileCounters * counters,
+                              int row, int first, int last, uint64_t lastMask){
+    for(int i = first; i < last - 1; i++){
+        countStats(current[i], next[i], counters, i - first, row);
+    }
+    countStats(current[last - 1] & lastMask, next[last - 1], counters, last - 1 - first, row);
+}
+
+// Gather the statistics of 8 words at once with AVX-512 (the last word is counted by popcnt)
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static void gatherStatsAvx512(const uint64_t * current, const uint64_t * next, TileCounters * counters,
+                              int row, int first, int last, uint64_t lastMask){
+    __m512i bit = _mm512_set1_epi64((long long)(1ULL << row));
+    __m512i old, word, rows;
+    __mmask8 used;
+    int i = first, c;
+    for(; i + 8 < last; i += 8){
+        c = i - first;
+        old = _mm512_loadu_si512(&current[i]);
+        word = _mm512_loadu_si512(&next[i]);
+        _mm512_storeu_si512(&counters->births[c], _mm512_add_epi64(_mm512_loadu_si512(&counters->births[c]),
+                                                                  _mm512_popcnt_epi64(_mm512_andnot_si512(old, word))));
+        _mm512_storeu_si512(&counters->deaths[c], _mm512_add_epi64(_mm512_loadu_si512(&counters->deaths[c]),
+                                                                  _mm512_popcnt_epi64(_mm512_andnot_si512(word, old))));
+        _mm512_storeu_si512(&counters->columns[c], _mm512_or_si512(_mm512_loadu_si512(&counters->columns[c]), word));
+        used = _mm512_test_epi64_mask(word, word);
+        rows = _mm512_loadu_si512(&counters->rows[c]);
+        _mm512_storeu_si512(&counters->rows[c], _mm512_mask_or_epi64(rows, used, rows, bit));
+    }
+    for(; i < last - 1; i++){
+        countStats(current[i], next[i], counters, i - first, row);
+    }
+    countStats(current[last - 1] & lastMask, next[last - 1], counters, last - 1 - first, row);
+}
+#endif
+
+// Get the kernel that gathers the statistics of the calculated rows
+// (it counts 8 words at once with AVX-512, or with the popcnt instruction if the processor supports them)
+// Return: Function pointer
+stats_kernel statsKernel(){
+#ifdef KERNEL_X86
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")){
+        return gatherStatsAvx512;
+    }
+    if(__builtin_cpu_supports("popcnt")){
+        return gatherStatsPopcnt;
+    }
+#endif
+    return gatherStats;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rule.h"
+
+// Implementations of the simulation step
+typedef enum step_kernel{
+    kernel_scalar,  // Count the neighbours of every cell one by one
+    kernel_bitwise, // Calculate 64 cells at once with bitwise adders
+    kernel_avx2,    // Bitwise adders on 256 bit registers (4 words at once)
+    kernel_avx512   // Bitwise adders on 512 bit registers (8 words at once)
+} step_kernel;
+
+// Statistics of a tile of the map (1 word x 64 rows), gathered while it is calculated
+typedef struct TileStats{
+    uint64_t columns;     // Columns of the tile with active cells (bit i: bit i of the word)
+    uint64_t rows;        // Rows of the tile with active cells (bit r: row r of the tile)
+    uint16_t population;  // Number of active cells
+    uint16_t births;      // Cells that became active when the tile was last calculated
+    uint16_t deaths;      // Cells that became inactive when the tile was last calculated
+} TileStats;
+
+// Kernel that calculates the next state of the words [first, last) of a row
+// above, row, below: current state of the row and its neighbours
+// (the words before first and after last - 1 are read as well)
+// next: the next state of the row
+// rule: the rule of the simulation (only read by the generic kernel, the others are specialized to one rule)
+typedef void (*word_kernel)(const uint64_t * above, const uint64_t * row, const uint64_t * below,
+                            uint64_t * next, int first, int last, Rule rule);
+
+// Largest number of tiles the statistics are gathered for at once
+#define TILE_COUNTER_WORDS 64
+
+// Counters of a run of neighbouring tiles while their rows are calculated
+// (element i belongs to the tile of word first + i of the rows)
+typedef struct TileCounters{
+    uint64_t births[TILE_COUNTER_WORDS];  // Cells that became active
+    uint64_t deaths[TILE_COUNTER_WORDS];  // Cells that became inactive
+    uint64_t columns[TILE_COUNTER_WORDS]; // Columns with active cells
+    uint64_t rows[TILE_COUNTER_WORDS];    // Rows with active cells (bit r: row r of the tile)
+} TileCounters;
+
+// Kernel that gathers the statistics of the words [first, last) of a calculated row
+// (last - first is at most TILE_COUNTER_WORDS)
+// current, next: the row before and after the step (the bits of next outside of the map are zero;
+// the rows of the tiles of the unbounded plane are rows of one word)
+// counters: the births, the deaths and the used columns and rows of the words are added to them
+// row: position of the row in its tiles (0-63)
+// lastMask: the cells of the word last - 1 (the bits outside of the map may hold a ghost cell on current)
+typedef void (*stats_kernel)(const uint64_t * current, const uint64_t * next, TileCounters * counters,
+                             int row, int first, int last, uint64_t lastMask);
+
+// Name of the kernel (used in command line options and log messages)
+// Return: Name of the kernel
+const char * kernelName(step_kernel kernel);
+
+// Find the kernel by its name
+// Return: TRUE if the name is valid, FALSE otherwise
+bool parseKernelName(const char * name, step_kernel * kernel);
+
+// Checks if the processor can run the kernel
+// Return: TRUE if the kernel is supported, FALSE otherwise
+bool kernelSupported(step_kernel kernel);
+
+// Select the fastest kernel the processor supports
+// Return: step_kernel
+step_kernel bestKernel();
+
+// Checks if the rule has its own kernels, or it is calculated by the generic kernel
+// Return: TRUE if the rule has specialized kernels, FALSE otherwise
+bool specializedRule(Rule rule);
+
+// Get the word kernel of a kernel that works on whole words
+// Rules with specialized kernels are calculated by them, the other rules by the generic kernel
+// Return: Function pointer, or NULL for the scalar kernel
+word_kernel wordKernel(step_kernel kernel, Rule rule);
+
+// Get the kernel that gathers the statistics of the calculated rows
+// (it counts 8 words at once with AVX-512, or with the popcnt instruction if the processor supports them)
+// Return: Function pointer
+stats_kernel statsKernel();
+
+#endif
\ No newline at end of file
@@ -1,124 +1,240 @@
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
-#include <stdio.h>
-
-#include "error.h"
-#include "simulation.h"
-#include "userInterface.h"
-#include "draw.h"
-#include "file.h"
-
-// After a failed attempt to allocate memory,
-// print error message and exit the program
-void notEnoughMemory(){
-    printf("Memory allocation failed!\n");
-    exit(0);
-}
-
-int main(int argc, char *argv[]){
-    SDL_TimerID timer;
-    SDL_Event ev;
-    Simulation sim;
-    const Uint8 * keyboardState = NULL;
-    bool updateFrame = false;
-    bool running = true;
-    bool speedSliderDragged = false;
-    int numOfButtons = 6;
-    Button buttons[numOfButtons];
-    
-    sim = simulation_create();
-    
-    if(SDL_Init(SDL_INIT_EVERYTHING) != 0){
-        return 0;
-    }
-    TTF_Init();
-    
-    keyboardState = SDL_GetKeyboardState(NULL);
-    timer = SDL_AddTimer((Uint32)(1 / (double)sim.speed * 1000), simulationStepper, &sim);
-    SDL_Window * window = NULL;
-    SDL_Renderer * renderer = NULL;
-    
-    if(SDL_CreateWindowAndRenderer(800, 600, 0, &window, &renderer) != 0){
-        return 0;
-    }
-    SDL_SetWindowTitle(window, "Conway's Game of Life");
-    initButtons(renderer, buttons);
-    generateLabel(renderer);
-    renderFrame(renderer, &sim, buttons, numOfButtons);
-    
-    while(running){
-        SDL_WaitEvent(&ev);
-        if(ev.type == SDL_QUIT){
-            // Exit
-            SDL_Quit();
-            running = false;
-        } else if(ev.type == SDL_MOUSEWHEEL){
-            // Zooming
-            updateFrame = true;
-            if(ev.wheel.y > 0)
-            {  
-                sim.zoom++;
-            }
-            else if(ev.wheel.y < 0)
-            {
-                if(sim.zoom > 1){
-                    sim.zoom--;
-                }
-            }
-        } else if(ev.type == SDL_MOUSEMOTION){
-            if(!userClickedOnMenu()){
-                updateFrame |= checkForEditing(&sim);
-            }
-            // Move view when SPACE is held down and 
-            // the cursor is moving
-            if(keyboardState[SDL_SCANCODE_SPACE]){
-                sim.offset.x += ev.motion.xrel;
-                sim.offset.y += ev.motion.yrel;
-                updateFrame = true;
-            }
-            if(speedSliderDragged && areaClicked(&speedBar)){
-                setSpeedSlider(&sim);
-                updateFrame = true;
-            }
-        } else if(ev.type == SDL_MOUSEBUTTONDOWN){
-            if(userClickedOnMenu()){
-                // Detect clicks on buttons
-                updateFrame |= buttonHandler(buttons, numOfButtons, &sim);
-                // Detect click on the speed slider
-                if(areaClicked(&speedBar)){
-                    setSpeedSlider(&sim);
-                    updateFrame = true;
-                    speedSliderDragged = true;
-                }
-            } else {
-                // Editing cell state
-                updateFrame |= checkForEditing(&sim);                
-            }
-        } else if(ev.type == SDL_MOUSEBUTTONUP){
-            speedSliderDragged = false;
-        } else if(ev.type == SDL_USEREVENT){
-            // Timer
-            // Step to next frame
-            if(ev.user.code == 1){
-                if(sim.running){
-                    cycle(&sim);
-                    updateFrame = true;
-                }
-            }
-        }
-        if(sim.command == load){
-            loadSimulationFromFile(&sim, &timer);
-            sim.command = no_command;
-        }
-        if(updateFrame){
-            // If the user edited a cell or the timer fired, then
-            // render the next frame
-            renderFrame(renderer, &sim, buttons, numOfButtons);
-            updateFrame = false;
-        }
-    }
-    TTF_Quit();
-    simulation_destroy(&sim, timer);
-
-    return 0;
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdio.h>
+
+#include "error.h"
+#include "simulation.h"
+#include "userInterface.h"
+#include "draw.h"
+#include "text.h"
+#include "file.h"
+#include "options.h"
+#include "headless.h"
+#include "simulationThread.h"
+
+// After a failed attempt to allocate memory,
+// print error message and exit the program
+void notEnoughMemory(){
+    printf("Memory allocation failed!\n");
+    exit(0);
+}
+
+int main(int argc, char *argv[]){
+    SimulationThread * simulationThread;
+    const Snapshot * snapshot;
+    SDL_Event ev;
+    Simulation sim;
+    const Uint8 * keyboardState = NULL;
+    bool updateFrame = false;
+    bool running = true;
+    bool speedSliderDragged = false;
+    int numOfButtons = 6;
+    Button buttons[numOfButtons];
+    char rule[RULE_NAME_LENGTH];
+    Options options = parseOptions(argc, argv);
+    
+    if(options.unbounded){
+        sim = simulation_initUnbounded();
+    } else if(options.headless){
+        // The dimensions are read from the input map
+        sim = simulation_init(0, 0);
+    } else {
+        sim = simulation_create();
+    }
+    sim.kernel = options.kernel;
+    sim.rule = options.rule;
+    sim.boundary = options.boundary;
+    sim.mapFile = options.mapFile;
+    printf("Simulation kernel: %s\n", kernelName(sim.kernel));
+    ruleName(sim.rule, rule);
+    printf("Simulation rule: %s%s\n", rule, specializedRule(sim.rule) ? "" : " (generic kernel)");
+    setThreadCount(&sim, options.threads);
+    printf("Simulation threads: %d\n", sim.pool == NULL ? 1 : sim.pool->numOfThreads);
+    if(options.fastForward >= 0){
+        sim.hashlife = hashlife_init((size_t)options.hashLifeMemory * 1024 * 1024);
+        sim.fastForwardExponent = options.fastForward;
+    }
+    if(options.historyMemory > 0 && !options.headless && !options.unbounded){
+        sim.history = history_init((size_t)options.historyMemory * 1024 * 1024);
+    }
+    if(options.onPeriod != period_off){
+        sim.period = period_init();
+        sim.stopWhenPeriodic = options.onPeriod == period_stop;
+    }
+    if(options.headless){
+        int result = runHeadless(&sim, &options);
+        simulation_free(&sim);
+        return result;
+    }
+    
+    if(SDL_Init(SDL_INIT_EVERYTHING) != 0){
+        return 0;
+    }
+    TTF_Init();
+    
+    keyboardState = SDL_GetKeyboardState(NULL);
+    SDL_Window * window = NULL;
+    SDL_Renderer * renderer = NULL;
+    
+    window = SDL_CreateWindow("Conway's Game of Life", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 800, 600, 0);
+    if(window == NULL){
+        return 0;
+    }
+    // Presenting a frame waits for the display refresh, so frames are drawn at the refresh rate
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if(renderer == NULL){
+        return 0;
+    }
+    text_init(options.font);
+    initButtons(renderer, buttons);
+    generateLabel(renderer);
+    // The simulation is advanced by its own thread from now on,
+    // the event loop locks it to modify it
+    simulationThread = simulationthread_init(&sim);
+    snapshot = latestSnapshot(simulationThread, sim.zoom < 0 ? -sim.zoom : 0, sampledBlocks(&sim));
+    renderFrame(renderer, &sim, snapshot, buttons, numOfButtons);
+    
+    while(running){
+        SDL_WaitEvent(&ev);
+        if(ev.type == SDL_QUIT){
+            // Exit
+            running = false;
+        } else if(ev.type == SDL_MOUSEWHEEL){
+            // Zooming
+            updateFrame = true;
+            if(ev.wheel.y > 0)
+            {  
+                sim.zoom++;
+            }
+            else if(ev.wheel.y < 0)
+            {
+                if(sim.zoom > MIN_ZOOM){
+                    sim.zoom--;
+                }
+            }
+        } else if(ev.type == SDL_MOUSEMOTION){
+            if(!userClickedOnMenu() && (ev.motion.state & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK))){
+                lockSimulation(simulationThread);
+                updateFrame |= checkForEditing(&sim);
+                unlockSimulation(simulationThread);
+            }
+            // Move view when SPACE is held down and 
+            // the cursor is moving
+            if(keyboardState[SDL_SCANCODE_SPACE]){
+                sim.offset.x += ev.motion.xrel;
+                sim.offset.y += ev.motion.yrel;
+                updateFrame = true;
+            }
+            if(speedSliderDragged && areaClicked(&speedBar)){
+                lockSimulation(simulationThread);
+                setSpeedSlider(&sim);
+                unlockSimulation(simulationThread);
+                updateFrame = true;
+            }
+        } else if(ev.type == SDL_MOUSEBUTTONDOWN){
+            lockSimulation(simulationThread);
+            if(userClickedOnMenu()){
+                // Detect clicks on buttons
+                updateFrame |= buttonHandler(buttons, numOfButtons, &sim);
+                // Detect click on the speed slider
+                if(areaClicked(&speedBar)){
+                    setSpeedSlider(&sim);
+                    updateFrame = true;
+                    speedSliderDragged = true;
+                }
+            } else {
+                // Editing cell state
+                updateFrame |= checkForEditing(&sim);                
+            }
+            unlockSimulation(simulationThread);
+        } else if(ev.type == SDL_KEYDOWN){
+            // Fast-forward with HashLife
+            // (only on the unbounded plane: HashLife would ignore the edges of a bounded map,
+            // and the event loop is the only thread that replaces the universe)
+            if(ev.key.keysym.sym == SDLK_f && sim.hashlife != NULL && sim.universe == NULL){
+                printf("Fast-forward only works on the unbounded plane (--infinite)\n");
+            } else if(ev.key.keysym.sym == SDLK_f && sim.hashlife != NULL){
+                lockSimulation(simulationThread);
+                if(sim.firstStart){
+                    saveCheckpoint(&sim, DEFAULT_CHECKPOINT);
+                    sim.firstStart = false;
+                }
+                fastForward(&sim);
+                unlockSimulation(simulationThread);
+                updateFrame = true;
+            }
+            // Performance overlay
+            if(ev.key.keysym.sym == SDLK_i){
+                toggleStatsOverlay();
+                updateFrame = true;
+            }
+            // History: LEFT steps backward, RIGHT steps forward (SHIFT: by 100 generations)
+            if(ev.key.keysym.sym == SDLK_LEFT || ev.key.keysym.sym == SDLK_RIGHT){
+                lockSimulation(simulationThread);
+                sim.running = false;
+                if(sim.firstStart){
+                    saveCheckpoint(&sim, DEFAULT_CHECKPOINT);
+                    sim.firstStart = false;
+                }
+                if(!seekGeneration(&sim, (ev.key.keysym.sym == SDLK_LEFT ? -1 : 1) *
+                                         ((ev.key.keysym.mod & KMOD_SHIFT) ? 100 : 1)) &&
+                   ev.key.keysym.sym == SDLK_RIGHT && !(ev.key.keysym.mod & KMOD_SHIFT)){
+                    // At the latest generation a step forward calculates the next one
+                    cycle(&sim);
+                }
+                unlockSimulation(simulationThread);
+                updateFrame = true;
+            }
+            // Checkpoints: SHIFT + digit saves the map, the digit restores it
+            if(ev.key.keysym.sym >= SDLK_0 && ev.key.keysym.sym <= SDLK_9){
+                lockSimulation(simulationThread);
+                if(ev.key.keysym.mod & KMOD_SHIFT){
+                    saveCheckpoint(&sim, ev.key.keysym.sym - SDLK_0);
+                    printf("Checkpoint %d saved\n", ev.key.keysym.sym - SDLK_0);
+                } else if(!restoreCheckpoint(&sim, ev.key.keysym.sym - SDLK_0)){
+                    printf("Checkpoint %d is empty\n", ev.key.keysym.sym - SDLK_0);
+                }
+                unlockSimulation(simulationThread);
+                updateFrame = true;
+            }
+        } else if(ev.type == SDL_MOUSEBUTTONUP){
+            speedSliderDragged = false;
+        } else if(ev.type == SDL_RENDER_TARGETS_RESET){
+            // The content of the back buffer was lost
+            markDirtyArea(&(SDL_Rect){0, 0, menu_area.x + menu_area.w, menu_area.h});
+            updateFrame = true;
+        } else if(ev.type == SDL_WINDOWEVENT && ev.window.event == SDL_WINDOWEVENT_EXPOSED){
+            // The window has to be repainted from the back buffer
+            updateFrame = true;
+        } else if(ev.type == SDL_USEREVENT){
+            // The simulation thread finished a new generation
+            if(ev.user.code == 1){
+                updateFrame = true;
+            }
+        }
+        if(sim.command == load){
+            lockSimulation(simulationThread);
+            loadSimulationFromFile(&sim);
+            sim.command = no_command;
+            unlockSimulation(simulationThread);
+            updateFrame = true;
+        }
+        if(updateFrame && !SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT)){
+            // If the user edited a cell or a new generation is finished, then
+            // render the next frame (after the pending events are handled)
+            snapshot = latestSnapshot(simulationThread, sim.zoom < 0 ? -sim.zoom : 0, sampledBlocks(&sim));
+            renderFrame(renderer, &sim, snapshot, buttons, numOfButtons);
+            updateFrame = false;
+        }
+    }
+    simulationthread_destroy(simulationThread);
+    draw_free();
+    text_free();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    TTF_Quit();
+    SDL_Quit();
+    simulation_free(&sim);
+
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "options.h"
+
+// Print the accepted command line options
+void printUsage(const char * program){
+    printf("Usage: %s [options]\n", program);
+    printf("  --kernel=NAME   Simulation step: scalar, bitwise, avx2, avx512\n");
+    printf("                  (default: the fastest one the processor supports)\n");
+    printf("  --rule=B/S      Rule of the simulation in B/S notation, e.g. B36/S23 (default: B3/S23)\n");
+    printf("                  (rules with B0 are not supported)\n");
+    printf("  --boundary=MODE Cells outside of the map: dead, torus (wrap around), mirror\n");
+    printf("                  (default: dead)\n");
+    printf("  --threads=N     Number of simulation threads (default: number of processor cores)\n");
+    printf("  --hashlife=K    Enable fast-forward (F key) by 2^K generations with HashLife\n");
+    printf("  --hashlife-memory=MB\n");
+    printf("                  Memory limit of the HashLife node cache (default: 512)\n");
+    printf("  --infinite      Simulate an unbounded plane instead of a map with fixed size\n");
+    printf("  --headless      Run the simulation without a window as fast as possible, then exit\n");
+    printf("  --generations=N Number of generations calculated in headless mode\n");
+    printf("  --input=PATH    Map loaded in headless mode (default: map.bin)\n");
+    printf("  --output=PATH   Final state saved in headless mode (default: result.bin)\n");
+    printf("  --stats=PATH    Performance counters written in headless mode (JSON)\n");
+    printf("  --cell-log=PATH Population, births, deaths and bounds of every generation\n");
+    printf("                  written in headless mode (CSV)\n");
+    printf("  --map=PATH      File used by the Save and Load buttons (default: map.bin)\n");
+    printf("                  (.rle and .cells patterns can be loaded too)\n");
+    printf("  --history=MB    Memory limit of the history of generations for stepping backward\n");
+    printf("                  (default: 64, 0: disabled)\n");
+    printf("  --on-period=ACTION\n");
+    printf("                  When the map becomes static or periodic: off, report, stop,\n");
+    printf("                  jump (headless: skip the remaining periods) (default: report)\n");
+    printf("  --font=PATH     TrueType font of the texts (default: Arial on Windows,\n");
+    printf("                  DejaVu Sans or Liberation Sans on Linux)\n");
+}
+
+// Get the value of an option in the form of --name=value
+// Return: The value, or NULL if the argument is not the given option
+static const char * optionValue(const char * arg, const char * name){
+    size_t length = strlen(name);
+    if(strncmp(arg, name, length) == 0 && arg[length] == '='){
+        return arg + length + 1;
+    }
+    return NULL;
+}
+
+// Parse the command line options
+// Unknown or invalid options print the usage and exit the program
+// Return: Options
+Options parseOptions(int argc, char * argv[]){
+    Options options;
+    const char * value;
+    options.kernel = bestKernel();
+    options.rule = RULE_CONWAY;
+    options.boundary = boundary_dead;
+    options.threads = 0;
+    options.fastForward = -1;
+    options.hashLifeMemory = 512;
+    options.unbounded = false;
+    options.headless = false;
+    options.generations = -1;
+    options.input = "map.bin";
+    options.output = "result.bin";
+    options.mapFile = "map.bin";
+    options.historyMemory = 64;
+    options.onPeriod = period_report;
+    options.font = NULL;
+    options.statsFile = NULL;
+    options.cellLog = NULL;
+    
+    for(int i = 1; i < argc; i++){
+        if((value = optionValue(argv[i], "--kernel")) != NULL){
+            if(!parseKernelName(value, &options.kernel)){
+                printf("Unknown kernel: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+            if(!kernelSupported(options.kernel)){
+                printf("The processor does not support the %s kernel, falling back to %s\n",
+                       value, kernelName(kernel_bitwise));
+                options.kernel = kernel_bitwise;
+            }
+        } else if((value = optionValue(argv[i], "--rule")) != NULL){
+            if(!parseRule(value, &options.rule)){
+                printf("Invalid rule: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--boundary")) != NULL){
+            if(strcmp(value, "dead") == 0){
+                options.boundary = boundary_dead;
+            } else if(strcmp(value, "torus") == 0){
+                options.boundary = boundary_torus;
+            } else if(strcmp(value, "mirror") == 0){
+                options.boundary = boundary_mirror;
+            } else {
+                printf("Unknown boundary mode: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--threads")) != NULL){
+            options.threads = atoi(value);
+            if(options.threads < 0){
+                printf("Invalid number of threads: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--hashlife")) != NULL){
+            options.fastForward = atoi(value);
+            if(options.fastForward < 0 || options.fastForward > 50){
+                printf("Invalid fast-forward exponent: %s (0-50)\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--hashlife-memory")) != NULL){
+            options.hashLifeMemory = atoi(value);
+            if(options.hashLifeMemory < 1){
+                printf("Invalid memory limit: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if(strcmp(argv[i], "--infinite") == 0){
+            options.unbounded = true;
+        } else if(strcmp(argv[i], "--headless") == 0){
+            options.headless = true;
+        } else if((value = optionValue(argv[i], "--generations")) != NULL){
+            options.generations = atoll(value);
+            if(options.generations < 0){
+                printf("Invalid number of generations: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--input")) != NULL){
+            options.input = value;
+        } else if((value = optionValue(argv[i], "--output")) != NULL){
+            options.output = value;
+        } else if((value = optionValue(argv[i], "--map")) != NULL){
+            options.mapFile = value;
+        } else if((value = optionValue(argv[i], "--history")) != NULL){
+            options.historyMemory = atoi(value);
+            if(options.historyMemory < 0){
+                printf("Invalid memory limit: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--on-period")) != NULL){
+            if(strcmp(value, "off") == 0){
+                options.onPeriod = period_off;
+            } else if(strcmp(value, "report") == 0){
+                options.onPeriod = period_report;
+            } else if(strcmp(value, "stop") == 0){
+                options.onPeriod = period_stop;
+            } else if(strcmp(value, "jump") == 0){
+                options.onPeriod = period_jump;
+            } else {
+                printf("Unknown period action: %s\n", value);
+                printUsage(argv[0]);
+                exit(1);
+            }
+        } else if((value = optionValue(argv[i], "--stats")) != NULL){
+            options.statsFile = value;
+        } else if((value = optionValue(argv[i], "--cell-log")) != NULL){
+            options.cellLog = value;
+        } else if((value = optionValue(argv[i], "--font")) != NULL){
+            options.font = value;
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printUsage(argv[0]);
+            exit(1);
+        }
+    }
+    if(options.headless && options.generations < 0){
+        printf("The number of generations must be given in headless mode\n");
+        printUsage(argv[0]);
+        exit(1);
+    }
+    return options;
+}
\ No newline at end of file
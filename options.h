@@ -0,0 +1,45 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdbool.h>
+#include "kernel.h"
+#include "simulation.h"
+
+// What happens when the map becomes static or periodic (--on-period=ACTION)
+typedef enum period_action{
+    period_off,     // The period is not detected
+    period_report,  // The period is printed
+    period_stop,    // The period is printed and the simulation stops
+    period_jump     // Headless mode skips the remaining whole periods (otherwise the same as report)
+} period_action;
+
+// Settings given on the command line
+typedef struct Options{
+    step_kernel kernel; // Implementation of the simulation step (--kernel=NAME)
+    Rule rule;          // Birth and survival conditions of the cells (--rule=B/S)
+    boundary_mode boundary; // Treatment of the cells outside of the map (--boundary=MODE)
+    int threads;        // Number of simulation threads, 0: number of processor cores (--threads=N)
+    int fastForward;    // HashLife fast-forward by 2^fastForward generations, -1: disabled (--hashlife=K)
+    int hashLifeMemory; // Memory limit of the HashLife node cache in megabytes (--hashlife-memory=MB)
+    bool unbounded;     // Simulate an unbounded plane instead of a map with fixed size (--infinite)
+    bool headless;      // Run without a window and exit (--headless)
+    long long generations; // Number of generations calculated in headless mode (--generations=N)
+    const char * input;    // Map loaded in headless mode (--input=PATH)
+    const char * output;   // Final state saved in headless mode (--output=PATH)
+    const char * mapFile;  // File used by the Save and Load buttons (--map=PATH)
+    int historyMemory;     // Memory limit of the generation history in megabytes, 0: disabled (--history=MB)
+    period_action onPeriod; // What happens when the map becomes static or periodic (--on-period=ACTION)
+    const char * font;     // TrueType font of the texts, NULL: the default font of the system (--font=PATH)
+    const char * statsFile; // Performance counters written in headless mode, NULL: not written (--stats=PATH)
+    const char * cellLog;   // Cell statistics of every generation in headless mode, NULL: not written (--cell-log=PATH)
+} Options;
+
+// Print the accepted command line options
+void printUsage(const char * program);
+
+// Parse the command line options
+// Unknown or invalid options print the usage and exit the program
+// Return: Options
+Options parseOptions(int argc, char * argv[]);
+
+#endif
\ No newline at end of file
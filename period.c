@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+#include "period.h"
+
+// Initialize a detector
+// Return: Pointer to the detector
+PeriodDetector * period_init(){
+    PeriodDetector * pd = calloc(1, sizeof(PeriodDetector));
+    if(pd == NULL){
+        notEnoughMemory();
+    }
+    return pd;
+}
+
+// Frees the memory allocated by the detector
+void period_free(PeriodDetector * pd){
+    if(pd == NULL){
+        return;
+    }
+    free(pd->tileHashes);
+    free(pd);
+}
+
+// Forget the recorded generations (it must be called when the map is modified other than by a step)
+void resetPeriod(PeriodDetector * pd){
+    memset(pd->table, 0, sizeof(pd->table));
+    pd->valid = false;
+    pd->generation = 0;
+    pd->period = 0;
+    pd->periodStart = 0;
+}
+
+// Mix the bits of a value
+// Return: Mixed value
+static uint64_t mix(uint64_t x){
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Hash of a tile at the given position
+// Return: Hash value (0 for an empty tile, so empty tiles don't change the hash of the map)
+static uint64_t tileHash(const uint64_t * words, int numOfWords, int64_t x, int64_t y){
+    uint64_t hash = mix((uint64_t)x * 0x9E3779B97F4A7C15ULL ^ (uint64_t)y);
+    uint64_t population = 0;
+    for(int r = 0; r < numOfWords; r++){
+        hash = mix(hash ^ words[r]);
+        population |= words[r];
+    }
+    return population == 0 ? 0 : hash;
+}
+
+// Hash of a tile of the map
+// Return: Hash value
+static uint64_t mapTileHash(const Bitmap * map, int tileX, int tileY){
+    uint64_t words[TILE_ROWS];
+    int rows = 0;
+    for(int y = tileY * TILE_ROWS; y < map->height && rows < TILE_ROWS; y++, rows++){
+        words[rows] = mapRow(map, y)[tileX];
+    }
+    return tileHash(words, rows, tileX, tileY);
+}
+
+// Add the current generation to the table and look for an earlier generation with the same hash
+// Return: TRUE if the map became periodic in this generation, FALSE otherwise
+static bool recordHash(PeriodDetector * pd){
+    PeriodEntry * entry = &pd->table[mix(pd->hash) & (PERIOD_TABLE_SIZE - 1)];
+    bool found = false;
+    pd->generation++;
+    if(pd->period == 0 && entry->generation != 0 && entry->hash == pd->hash){
+        pd->period = (int)(pd->generation - entry->generation);
+        pd->periodStart = entry->generation;
+        found = true;
+    }
+    entry->hash = pd->hash;
+    entry->generation = pd->generation;
+    return found;
+}
+
+// Record a generation of the map, only the hashes of the changed tiles are calculated again
+// (changed: flags of the tiles that changed in the last step)
+// Return: TRUE if the map became periodic in this generation, FALSE otherwise
+bool recordMapPeriod(PeriodDetector * pd, const Bitmap * map, const uint8_t * changed, int columns, int rows){
+    size_t numOfTiles = (size_t)columns * rows;
+    size_t tile;
+    uint64_t hash;
+    if(!pd->valid || pd->numOfTiles != numOfTiles){
+        // Hash every tile
+        if(pd->numOfTiles != numOfTiles){
+            free(pd->tileHashes);
+            pd->tileHashes = malloc((numOfTiles + 1) * sizeof(uint64_t));
+            if(pd->tileHashes == NULL){
+                notEnoughMemory();
+            }
+            pd->numOfTiles = numOfTiles;
+        }
+        pd->hash = 0;
+        for(int ty = 0; ty < rows; ty++){
+            for(int tx = 0; tx < columns; tx++){
+                tile = (size_t)ty * columns + tx;
+                pd->tileHashes[tile] = mapTileHash(map, tx, ty);
+                pd->hash ^= pd->tileHashes[tile];
+            }
+        }
+        pd->valid = true;
+        return recordHash(pd);
+    }
+    for(int ty = 0; ty < rows; ty++){
+        for(int tx = 0; tx < columns; tx++){
+            tile = (size_t)ty * columns + tx;
+            if(changed[tile]){
+                hash = mapTileHash(map, tx, ty);
+                pd->hash ^= pd->tileHashes[tile] ^ hash;
+                pd->tileHashes[tile] = hash;
+            }
+        }
+    }
+    return recordHash(pd);
+}
+
+// Record a generation of the unbounded plane
+// (the tiles of the plane are created and freed by the steps, so every tile is hashed)
+// Return: TRUE if the plane became periodic in this generation, FALSE otherwise
+bool recordUniversePeriod(PeriodDetector * pd, const Universe * u){
+    pd->hash = 0;
+    for(int i = 0; i < u->numOfTiles; i++){
+        pd->hash ^= tileHash(u->tiles[i]->cells, UNIVERSE_TILE_SIZE, u->tiles[i]->x, u->tiles[i]->y);
+    }
+    return recordHash(pd);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef PERIOD_H
+#define PERIOD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bitmap.h"
+#include "universe.h"
+
+// Number of generations remembered by the detector (power of two)
+// Periods up to about this length are detected
+#define PERIOD_TABLE_SIZE 4096
+
+// Generation with the given hash of the map
+typedef struct PeriodEntry{
+    uint64_t hash;          // Hash of the map
+    long long generation;   // Generation (0: empty entry)
+} PeriodEntry;
+
+// Detects when the map becomes static or periodic
+// The hash of the map is the XOR of the hashes of its tiles, so after a step only the hashes
+// of the changed tiles are calculated again. The recent generations are stored in a hash table by
+// the hash of the map: when a hash comes back, the map repeats with the period between the two generations.
+typedef struct PeriodDetector{
+    uint64_t * tileHashes;  // Hash of every tile of the map
+    size_t numOfTiles;      // Number of tiles in the array
+    bool valid;             // The tile hashes belong to the current map (FALSE: they are calculated again)
+    uint64_t hash;          // Hash of the map
+    long long generation;   // Number of generations since the detector was reset
+    int period;             // Period of the map (1: static, 0: not detected yet)
+    long long periodStart;  // First generation since the reset that repeats with the period
+    PeriodEntry table[PERIOD_TABLE_SIZE]; // Recent generations by hash
+} PeriodDetector;
+
+// Initialize a detector
+// Return: Pointer to the detector
+PeriodDetector * period_init();
+
+// Frees the memory allocated by the detector
+void period_free(PeriodDetector * pd);
+
+// Forget the recorded generations (it must be called when the map is modified other than by a step)
+void resetPeriod(PeriodDetector * pd);
+
+// Record a generation of the map, only the hashes of the changed tiles are calculated again
+// (changed: flags of the tiles that changed in the last step)
+// Return: TRUE if the map became periodic in this generation, FALSE otherwise
+bool recordMapPeriod(PeriodDetector * pd, const Bitmap * map, const uint8_t * changed, int columns, int rows);
+
+// Record a generation of the unbounded plane
+// (the tiles of the plane are created and freed by the steps, so every tile is hashed)
+// Return: TRUE if the plane became periodic in this generation, FALSE otherwise
+bool recordUniversePeriod(PeriodDetector * pd, const Universe * u);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+#include "pyramid.h"
+
+// Get a block of a stored level
+// Return: Number of active cells, 0 outside of the map
+static uint32_t storedCount(const Pyramid * p, int level, int x, int y){
+    int i = level - PYRAMID_FIRST_LEVEL;
+    if(x < 0 || y < 0 || x >= p->columns[i] || y >= p->rows[i]){
+        return 0;
+    }
+    return p->counts[i][(size_t)y * p->columns[i] + x];
+}
+
+// Calculate a block of a level from its four blocks on the level below
+static void sumChildren(Pyramid * p, int level, int x, int y){
+    int i = level - PYRAMID_FIRST_LEVEL;
+    if(x >= p->columns[i] || y >= p->rows[i]){
+        return;
+    }
+    p->counts[i][(size_t)y * p->columns[i] + x] =
+        storedCount(p, level - 1, 2 * x, 2 * y)     + storedCount(p, level - 1, 2 * x + 1, 2 * y) +
+        storedCount(p, level - 1, 2 * x, 2 * y + 1) + storedCount(p, level - 1, 2 * x + 1, 2 * y + 1);
+}
+
+// Allocate an empty pyramid for a map with the given dimensions
+// (the last level is a single block that covers the whole map)
+// Return: Pyramid
+Pyramid pyramid_init(int width, int height){
+    Pyramid p;
+    int level = PYRAMID_FIRST_LEVEL;
+    int size = width > height ? width : height;
+    
+    p.numOfLevels = 0;
+    // The levels inside a tile are always stored, the levels above them until one block covers the map
+    while(p.numOfLevels < PYRAMID_MAX_LEVELS &&
+          (level <= PYRAMID_TILE_LEVEL || ((size - 1) >> (level - 1)) > 0)){
+        p.columns[p.numOfLevels] = (width + (1 << level) - 1) >> level;
+        p.rows[p.numOfLevels] = (height + (1 << level) - 1) >> level;
+        // One extra element, so an empty map also gets a valid allocation
+        p.counts[p.numOfLevels] = calloc((size_t)p.columns[p.numOfLevels] * p.rows[p.numOfLevels] + 1, sizeof(uint32_t));
+        if(p.counts[p.numOfLevels] == NULL){
+            notEnoughMemory();
+        }
+        p.numOfLevels++;
+        level++;
+    }
+    return p;
+}
+
+// Frees the memory allocated by the pyramid
+void pyramid_free(Pyramid * p){
+    for(int i = 0; i < p->numOfLevels; i++){
+        free(p->counts[i]);
+        p->counts[i] = NULL;
+    }
+    p->numOfLevels = 0;
+}
+
+// Number of bytes allocated by the pyramid
+// Return: Size in bytes
+size_t pyramidSize(const Pyramid * p){
+    size_t size = 0;
+    for(int i = 0; i < p->numOfLevels; i++){
+        size += ((size_t)p->columns[i] * p->rows[i] + 1) * sizeof(uint32_t);
+    }
+    return size;
+}
+
+// Copy a rectangle of blocks of a level to another pyramid (it is reallocated if the dimensions are different)
+// (the other levels and blocks of dst are left as they are; above the top level the block of the top level is copied)
+// x, y, w, h: blocks of the level, the part outside of the level is skipped
+void copyPyramidBlocks(Pyramid * dst, const Pyramid * src, int level, int x, int y, int w, int h){
+    int i = level - PYRAMID_FIRST_LEVEL;
+    int first, last;
+    
+    if(dst->numOfLevels != src->numOfLevels || dst->columns[0] != src->columns[0] || dst->rows[0] != src->rows[0]){
+        pyramid_free(dst);
+        *dst = *src;
+        for(int k = 0; k < src->numOfLevels; k++){
+            dst->counts[k] = malloc(((size_t)src->columns[k] * src->rows[k] + 1) * sizeof(uint32_t));
+            if(dst->counts[k] == NULL){
+                notEnoughMemory();
+            }
+        }
+    }
+    if(i >= src->numOfLevels){
+        // The top level is a single block that covers the whole map
+        i = src->numOfLevels - 1;
+        x = y = 0;
+        w = h = 1;
+    }
+    first = x > 0 ? x : 0;
+    last = x + w < src->columns[i] ? x + w : src->columns[i];
+    if(first >= last){
+        return;
+    }
+    for(int r = y > 0 ? y : 0; r < y + h && r < src->rows[i]; r++){
+        memcpy(&dst->counts[i][(size_t)r * src->columns[i] + first], &src->counts[i][(size_t)r * src->columns[i] + first],
+               (size_t)(last - first) * sizeof(uint32_t));
+    }
+}
+
+// Count the active cells of a tile of the map again, and update the blocks that contain the tile
+// (tileX: word column of the map, tileY: row of 64 rows)
+void updatePyramidTile(Pyramid * p, const Bitmap * map, int tileX, int tileY){
+    const uint64_t m1 = 0x5555555555555555ULL;
+    const uint64_t m2 = 0x3333333333333333ULL;
+    const uint64_t m4 = 0x0F0F0F0F0F0F0F0FULL;
+    int blocksPerTile = WORD_BITS >> PYRAMID_FIRST_LEVEL;
+    int blockSize = 1 << PYRAMID_FIRST_LEVEL;
+    int firstBlockX = tileX * blocksPerTile;
+    int firstBlockY = tileY * blocksPerTile;
+    uint32_t * counts = p->counts[0];
+    uint64_t word, sums;
+    int y, x;
+    
+    // Lowest level: the active cells of each byte of 8 rows are counted at once
+    // (the count of every byte stays in that byte, at most 64)
+    for(int by = 0; by < blocksPerTile && firstBlockY + by < p->rows[0]; by++){
+        sums = 0;
+        for(int r = 0; r < blockSize; r++){
+            y = (firstBlockY + by) * blockSize + r;
+            if(y >= map->height){
+                break;
+            }
+            word = mapRow(map, y)[tileX];
+            word = word - ((word >> 1) & m1);
+            word = (word & m2) + ((word >> 2) & m2);
+            sums += (word + (word >> 4)) & m4;
+        }
+        for(int bx = 0; bx < blocksPerTile; bx++){
+            x = firstBlockX + bx;
+            if(x < p->columns[0]){
+                counts[(size_t)(firstBlockY + by) * p->columns[0] + x] = (uint32_t)((sums >> (bx * 8)) & 0xFF);
+            }
+        }
+    }
+    // Levels inside the tile
+    for(int level = PYRAMID_FIRST_LEVEL + 1; level <= PYRAMID_TILE_LEVEL; level++){
+        blocksPerTile >>= 1;
+        for(int by = 0; by < blocksPerTile; by++){
+            for(int bx = 0; bx < blocksPerTile; bx++){
+                sumChildren(p, level, tileX * blocksPerTile + bx, tileY * blocksPerTile + by);
+            }
+        }
+    }
+    // The blocks above the tile
+    for(int level = PYRAMID_TILE_LEVEL + 1; level < PYRAMID_FIRST_LEVEL + p->numOfLevels; level++){
+        sumChildren(p, level, tileX >> (level - PYRAMID_TILE_LEVEL), tileY >> (level - PYRAMID_TILE_LEVEL));
+    }
+}
+
+// Get the number of active cells in a block
+// (levels below PYRAMID_FIRST_LEVEL are counted from the map)
+// Return: Number of active cells, 0 outside of the map
+uint32_t blockPopulation(const Pyramid * p, const Bitmap * map, int level, int x, int y){
+    int top = PYRAMID_FIRST_LEVEL + p->numOfLevels - 1;
+    int size = 1 << level;
+    uint32_t population = 0;
+    uint64_t mask;
+    
+    if(x < 0 || y < 0){
+        return 0;
+    }
+    if(level >= PYRAMID_FIRST_LEVEL){
+        if(level > top){
+            // The block contains the whole map
+            return x == 0 && y == 0 ? storedCount(p, top, 0, 0) : 0;
+        }
+        return storedCount(p, level, x, y);
+    }
+    // Small blocks never cross a word boundary
+    if(x * size >= map->width){
+        return 0;
+    }
+    mask = (((uint64_t)1 << size) - 1) << ((x * size) & (WORD_BITS - 1));
+    for(int r = y * size; r < (y + 1) * size && r < map->height; r++){
+        population += __builtin_popcountll(mapRow(map, r)[(x * size) >> 6] & mask);
+    }
+    return population;
+}
\ No newline at end of file
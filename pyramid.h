@@ -0,0 +1,53 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stdint.h>
+#include "bitmap.h"
+
+// Level of the first stored level of the pyramid (blocks of 2^3 x 2^3 cells)
+// The smaller blocks are counted from the map when they are needed
+#define PYRAMID_FIRST_LEVEL 3
+
+// Level of the blocks that cover a tile of the map (64 x 64 cells)
+#define PYRAMID_TILE_LEVEL 6
+
+// Maximum number of stored levels
+#define PYRAMID_MAX_LEVELS 32
+
+// Population counts of the map at multiple resolutions
+// Level k divides the map into blocks of 2^k x 2^k cells and stores the number of active cells in each.
+// The levels are updated tile by tile, only for the tiles that changed.
+typedef struct Pyramid{
+    int numOfLevels;                       // Number of stored levels (PYRAMID_FIRST_LEVEL, PYRAMID_FIRST_LEVEL + 1, ...)
+    int columns[PYRAMID_MAX_LEVELS];       // Number of blocks in a row on each level
+    int rows[PYRAMID_MAX_LEVELS];          // Number of blocks in a column on each level
+    uint32_t * counts[PYRAMID_MAX_LEVELS]; // Number of active cells in each block
+} Pyramid;
+
+// Allocate an empty pyramid for a map with the given dimensions
+// (the last level is a single block that covers the whole map)
+// Return: Pyramid
+Pyramid pyramid_init(int width, int height);
+
+// Frees the memory allocated by the pyramid
+void pyramid_free(Pyramid * p);
+
+// Copy a rectangle of blocks of a level to another pyramid (it is reallocated if the dimensions are different)
+// (the other levels and blocks of dst are left as they are; above the top level the block of the top level is copied)
+// x, y, w, h: blocks of the level, the part outside of the level is skipped
+void copyPyramidBlocks(Pyramid * dst, const Pyramid * src, int level, int x, int y, int w, int h);
+
+// Number of bytes allocated by the pyramid
+// Return: Size in bytes
+size_t pyramidSize(const Pyramid * p);
+
+// Count the active cells of a tile of the map again, and update the blocks that contain the tile
+// (tileX: word column of the map, tileY: row of 64 rows)
+void updatePyramidTile(Pyramid * p, const Bitmap * map, int tileX, int tileY);
+
+// Get the number of active cells in a block
+// (levels below PYRAMID_FIRST_LEVEL are counted from the map)
+// Return: Number of active cells, 0 outside of the map
+uint32_t blockPopulation(const Pyramid * p, const Bitmap * map, int level, int x, int y);
+
+#endif
\ No newline at end of file
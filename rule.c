@@ -0,0 +1,99 @@
+#include <ctype.h>
+#include "rule.h"
+
+// Valid bits of the masks (0-8 neighbours)
+#define RULE_MASK 0x1FF
+
+// Parse a list of neighbour counts (e.g. "236") into a mask
+// Return: Pointer to the first character after the list
+static const char * parseCounts(const char * text, uint16_t * mask){
+    *mask = 0;
+    for(; *text >= '0' && *text <= '8'; text++){
+        *mask |= 1 << (*text - '0');
+    }
+    return text;
+}
+
+// Parse a rule in B/S notation (e.g. B36/S23), the S/B order and the "23/3" (survival/birth) notation are accepted too
+// Rules with B0 are rejected: every empty area would become active, so they don't work on the unbounded plane,
+// with HashLife and with the tiles that are skipped because they didn't change.
+// Return: TRUE if the rule is valid, FALSE otherwise
+bool parseRule(const char * text, Rule * rule){
+    Rule parsed = {0, 0};
+    bool birth = false, survival = false;
+    uint16_t mask;
+    char letter;
+
+    if(isdigit((unsigned char)text[0]) || text[0] == '/'){
+        // Survival/birth without letters
+        text = parseCounts(text, &parsed.survival);
+        if(*text++ != '/'){
+            return false;
+        }
+        text = parseCounts(text, &parsed.birth);
+    } else {
+        for(int part = 0; part < 2; part++){
+            letter = (char)toupper((unsigned char)*text++);
+            text = parseCounts(text, &mask);
+            if(letter == 'B' && !birth){
+                parsed.birth = mask;
+                birth = true;
+            } else if(letter == 'S' && !survival){
+                parsed.survival = mask;
+                survival = true;
+            } else {
+                return false;
+            }
+            if(part == 0 && *text++ != '/'){
+                return false;
+            }
+        }
+    }
+    if(*text != '\0' || (parsed.birth & 1)){
+        return false;
+    }
+    *rule = parsed;
+    return true;
+}
+
+// Write the rule in B/S notation
+void ruleName(Rule rule, char name[RULE_NAME_LENGTH]){
+    int length = 0;
+    name[length++] = 'B';
+    for(int n = 0; n <= 8; n++){
+        if(rule.birth >> n & 1){
+            name[length++] = (char)('0' + n);
+        }
+    }
+    name[length++] = '/';
+    name[length++] = 'S';
+    for(int n = 0; n <= 8; n++){
+        if(rule.survival >> n & 1){
+            name[length++] = (char)('0' + n);
+        }
+    }
+    name[length] = '\0';
+}
+
+// Checks if two rules are the same
+// Return: TRUE if they are, FALSE otherwise
+bool sameRule(Rule a, Rule b){
+    return a.birth == b.birth && a.survival == b.survival;
+}
+
+// Encode the rule into a number for the map files (birth mask in the low 16 bits, survival mask in the high 16 bits)
+// Return: Encoded rule
+uint32_t encodeRule(Rule rule){
+    return (uint32_t)rule.birth | (uint32_t)rule.survival << 16;
+}
+
+// Decode a rule stored in a map file
+// Return: TRUE if the rule is valid, FALSE otherwise
+bool decodeRule(uint32_t code, Rule * rule){
+    Rule decoded = {(uint16_t)(code & 0xFFFF), (uint16_t)(code >> 16)};
+    if((decoded.birth & ~RULE_MASK) || (decoded.survival & ~RULE_MASK) || (decoded.birth & 1)){
+        return false;
+    }
+    *rule = decoded;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef RULE_H
+#define RULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Longest name of a rule ("B012345678/S012345678" and the terminating zero)
+#define RULE_NAME_LENGTH 22
+
+// Life-like rule in B/S notation
+// Bit n of the masks is set if a cell with n active neighbours is born or survives
+typedef struct Rule{
+    uint16_t birth;     // Neighbour counts that make a dead cell alive
+    uint16_t survival;  // Neighbour counts that keep an active cell alive
+} Rule;
+
+// Conway's Game of Life (B3/S23)
+#define RULE_CONWAY ((Rule){1 << 3, 1 << 2 | 1 << 3})
+
+// Parse a rule in B/S notation (e.g. B36/S23), the S/B order and the "23/3" (survival/birth) notation are accepted too
+// Rules with B0 are rejected: every empty area would become active, so they don't work on the unbounded plane,
+// with HashLife and with the tiles that are skipped because they didn't change.
+// Return: TRUE if the rule is valid, FALSE otherwise
+bool parseRule(const char * text, Rule * rule);
+
+// Write the rule in B/S notation
+void ruleName(Rule rule, char name[RULE_NAME_LENGTH]);
+
+// Checks if two rules are the same
+// Return: TRUE if they are, FALSE otherwise
+bool sameRule(Rule a, Rule b);
+
+// Encode the rule into a number for the map files (birth mask in the low 16 bits, survival mask in the high 16 bits)
+// Return: Encoded rule
+uint32_t encodeRule(Rule rule);
+
+// Decode a rule stored in a map file
+// Return: TRUE if the rule is valid, FALSE otherwise
+bool decodeRule(uint32_t code, Rule * rule);
+
+// Next state of a cell (used by the kernels that count the neighbours one by one)
+// Return: 1 if the cell will be active, 0 otherwise
+static inline int nextCellState(Rule rule, int state, int neighbours){
+    return ((state ? rule.survival : rule.birth) >> neighbours) & 1;
+}
+
+#endif
\ No newline at end of file
@@ -1,186 +1,824 @@
-#include <stdio.h>
-#include "error.h"
-#include "simulation.h"
-#include "userInterface.h"
-
-// Clear the map
-void clearMap(Simulation * sim, int ** map){
-    for(int i = 0; i < sim->size.height; i++){
-        memset(map[i], 0, sim->size.width * sizeof(int));
-    }
-}
-
-// Calculate how many neighbours the given cell has
-void recordNeighbourCells(Simulation * sim, int cellX, int cellY){
-    for(int i = -1; i <= 1; i++){
-        for(int j = -1; j <= 1; j++){
-            if(i != 0 || j != 0){
-                if(cellX + i >= 0 && cellX + i < sim->size.width &&
-                   cellY + j >= 0 && cellY + j < sim->size.height){
-                    sim->tempMap[cellY + j][cellX + i]++;
-                }
-            }
-        }
-    }
-}
-
-// To calculate the next simulation state,
-// count how many neighbours each cell has
-void countNeighbourCells(Simulation * sim){
-    clearMap(sim, sim->tempMap);
-    for(int y = 0; y < sim->size.height; y++){
-        for(int x = 0; x < sim->size.width; x++){
-            if(sim->map[y][x] == active){
-                recordNeighbourCells(sim, x, y);
-            }
-        }
-    }
-}
-
-// Advance the simulation to the next state
-void cycle(Simulation * sim){
-    int numOfNeighbour;
-    
-    countNeighbourCells(sim);
-    for(int y = 0; y < sim->size.height; y++){
-        for(int x = 0; x < sim->size.width; x++){
-            numOfNeighbour = sim->tempMap[y][x];
-            if(numOfNeighbour >= 2 && numOfNeighbour <= 3){
-                // If the cell has two neighbours, the cell will remain unchanged
-                if(numOfNeighbour == 3){
-                    sim->map[y][x] = active;
-                }
-            } else {
-                sim->map[y][x] = empty;
-            }
-        }
-    }
-}
-
-// Copy the content of the map to another
-// (it is used to calculate next state on an auxiliary map)
-void copyMap(Simulation * sim, int ** dst, int ** src){
-    for(int i = 0; i < sim->size.height; i++){
-        memcpy(dst[i], src[i], sim->size.width * sizeof(int));
-    }
-}
-
-// Save current map as checkpoint
-void setAsDefaultMap(Simulation * sim){
-    copyMap(sim, sim->defaultMap, sim->map);
-}
-
-// Restore checkpoint
-void restoreDefaultMap(Simulation * sim){
-    copyMap(sim, sim->map, sim->defaultMap);
-}
-
-// Set simulation speed given by the speed slider
-void setSpeedSlider(Simulation * sim){
-    int mouseX, mouseY, speed;
-    SDL_GetMouseState(&mouseX, &mouseY);
-    speed = (mouseX - speedBar.x) / (speedBar.w / 50) + 1;
-    if(speed < 1){
-        speed = 1;
-    } else if(speed > 50){
-        speed = 50;
-    }
-    sim->speed = speed;
-}
-
-// Timer to create continuous simulation
-Uint32 simulationStepper(Uint32 interval, void * param){
-    Simulation * sim = (Simulation*)param;
-    SDL_Event event;
-    SDL_UserEvent userevent;
-
-    userevent.type = SDL_USEREVENT;
-    userevent.code = 1;
-    userevent.data1 = NULL;
-    userevent.data2 = NULL;
-
-    event.type = SDL_USEREVENT;
-    event.user = userevent;
-
-    SDL_PushEvent(&event);
-    return (Uint32)(1 / (double)sim->speed * 1000);
-}
-
-// Initialize the simulation structure
-// Return: Simulation
-Simulation simulation_init(int width, int height){
-    Simulation sim;
-    sim.size = (Size){width, height};
-    sim.offset = (Offset){0,0};
-    sim.running = false;
-    sim.firstStart = true;
-    sim.command = no_command;
-    sim.speed = 1;
-    sim.zoom = 11;
-    sim.map = malloc(sim.size.height * sizeof(int *));
-    if(sim.map == NULL){
-        notEnoughMemory();
-    }
-    sim.tempMap = malloc(sim.size.height * sizeof(int *));
-    if(sim.tempMap == NULL){
-        notEnoughMemory();
-    }
-    sim.defaultMap = malloc(sim.size.height * sizeof(int *));
-    if(sim.defaultMap == NULL){
-        notEnoughMemory();
-    }
-    for(int i = 0; i < sim.size.height; i++){
-        sim.map[i] = calloc(sim.size.width, sizeof(int));
-        if(sim.map[i] == NULL){
-            notEnoughMemory();
-        }
-        sim.tempMap[i] = calloc(sim.size.width, sizeof(int));
-        if(sim.tempMap[i] == NULL){
-            notEnoughMemory();
-        }
-        sim.defaultMap[i] = calloc(sim.size.width, sizeof(int));
-        if(sim.defaultMap[i] == NULL){
-            notEnoughMemory();
-        }
-    }
-    return sim;
-}
-
-// Frees the memory allocated by the simulation
-void simulation_free(Simulation * sim){
-    for(int i = 0; i < sim->size.height; i++){
-        free(sim->map[i]);
-        free(sim->tempMap[i]);
-        free(sim->defaultMap[i]);
-    }
-    free(sim->defaultMap);
-    free(sim->tempMap);
-    free(sim->map);
-}
-
-// Frees the simulation structure and stops the SDL timer
-void simulation_destroy(Simulation * sim, SDL_TimerID timer){
-    SDL_RemoveTimer(timer);
-    simulation_free(sim);
-}
-
-// Initialize a new simulation with the given dimensions
-void simulation_reinit(Simulation * sim, SDL_TimerID * timer, int width, int height){
-    simulation_destroy(sim, *timer);
-    *sim = simulation_init(width, height);
-    *timer = SDL_AddTimer((Uint32)(1 / (double)sim->speed * 1000), simulationStepper, sim);
-}
-
-// Prompt the user to enter the dimensions and then
-// create the simulation
-// Return: Simulation
-Simulation simulation_create(){
-    int width, height;
-    printf("Enter the dimensions!\n");
-    printf("Width: ");
-    scanf("%d", &width);
-    printf("Height: ");
-    scanf("%d", &height);
-    
-    return simulation_init(width, height);
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "error.h"
+#include "simulation.h"
+#include "userInterface.h"
+
+// Number of bands per thread (more bands than threads balance the load)
+#define BANDS_PER_THREAD 4
+
+// Maps smaller than this (in words) are calculated on a single thread
+#define MIN_PARALLEL_WORDS 4096
+
+// Parameters of a simulation step
+typedef struct StepTask{
+    Simulation * sim;        // Simulation
+    int bandHeight;          // Number of tile rows in a band
+    CellStats * bands;       // Statistics gathered by each band (added up after the step)
+} StepTask;
+
+// Calculate how many neighbours the given cell has
+// (the ghost cells around the map are read without bounds checks, they are filled by the step)
+// Return: Number of active neighbours
+int countNeighbourCells(Simulation * sim, int cellX, int cellY){
+    int neighbours = 0;
+    for(int i = -1; i <= 1; i++){
+        for(int j = -1; j <= 1; j++){
+            if(i != 0 || j != 0){
+                neighbours += getCell(&sim->map, cellX + i, cellY + j);
+            }
+        }
+    }
+    return neighbours;
+}
+
+// Calculate the next state of the words [first, last) of a row cell by cell
+void stepRowScalar(Simulation * sim, int y, int first, int last){
+    int numOfNeighbour, x;
+    uint64_t word, * row;
+    
+    row = mapRow(&sim->tempMap, y);
+    for(int w = first; w < last; w++){
+        word = mapRow(&sim->map, y)[w];
+        for(int bit = 0; bit < WORD_BITS; bit++){
+            x = w * WORD_BITS + bit;
+            if(x >= sim->size.width){
+                break;
+            }
+            numOfNeighbour = countNeighbourCells(sim, x, y);
+            if(nextCellState(sim->rule, (int)(word >> bit) & 1, numOfNeighbour)){
+                word |= (uint64_t)1 << bit;
+            } else {
+                word &= ~((uint64_t)1 << bit);
+            }
+        }
+        row[w] = word;
+    }
+}
+
+// Calculate the next state of the words [first, last) of a row on the auxiliary map
+// with the selected kernel
+void stepRow(Simulation * sim, int y, int first, int last){
+    Bitmap * map = &sim->map;
+    uint64_t * next = mapRow(&sim->tempMap, y);
+    switch(sim->kernel){
+        case kernel_scalar:
+            stepRowScalar(sim, y, first, last);
+            break;
+        default:
+            sim->stepWords(mapRow(map, y - 1), mapRow(map, y), mapRow(map, y + 1), next, first, last, sim->rule);
+            break;
+    }
+    // Cells can be born in the unused bits of the last word, and it may hold a ghost cell
+    if(last == map->words){
+        next[last - 1] &= lastWordMask(map);
+    }
+}
+
+// Fill the ghost cells left and right of a row (the left guard word and the bit after the last cell)
+static void fillGhostColumns(Simulation * sim, int y){
+    Bitmap * map = &sim->map;
+    bool torus = sim->boundary == boundary_torus;
+    mapRow(map, y)[-1] = (uint64_t)getCell(map, torus ? map->width - 1 : 0, y) << 63;
+    setCell(map, map->width, y, getCell(map, torus ? 0 : map->width - 1, y));
+}
+
+// Clear the ghost cells left and right of a row
+static void clearGhostColumns(Bitmap * map, int y){
+    uint64_t * row = mapRow(map, y);
+    row[-1] = 0;
+    row[map->words - 1] &= lastWordMask(map);
+    row[map->words] = 0;
+}
+
+// Find the tile rows whose ghost columns are read by the step
+// The tiles on the left and right edge are calculated if an edge tile or its inner neighbour changed
+// in the tile row or the ones next to it, and they read the rows above and below as well.
+static void findGhostTileRows(Simulation * sim, uint8_t * ghostRows){
+    Tiles * tiles = &sim->tiles;
+    int columns = tiles->columns, rows = tiles->rows;
+    int edgeColumns[4] = {0, 1, columns - 2, columns - 1};
+    uint8_t edgeChanged[rows];
+    int r;
+    for(int ty = 0; ty < rows; ty++){
+        edgeChanged[ty] = 0;
+        for(int i = 0; i < 4; i++){
+            if(edgeColumns[i] >= 0 && edgeColumns[i] < columns){
+                edgeChanged[ty] |= tiles->changed[(size_t)ty * columns + edgeColumns[i]];
+            }
+        }
+    }
+    for(int ty = 0; ty < rows; ty++){
+        ghostRows[ty] = 0;
+        for(int d = -2; d <= 2; d++){
+            r = ty + d;
+            if(sim->boundary == boundary_torus){
+                r = (r % rows + rows) % rows;
+            } else if(r < 0 || r >= rows){
+                continue;
+            }
+            ghostRows[ty] |= edgeChanged[r];
+        }
+    }
+}
+
+// Fill the ghost cells around the map before a step (with the dead boundary they stay zero)
+// The kernels read them as the neighbours of the cells on the edges, so they need no bounds checks.
+// ghostRows: the tile rows whose ghost columns are filled (see findGhostTileRows())
+static void fillGhostCells(Simulation * sim, const uint8_t * ghostRows){
+    Bitmap * map = &sim->map;
+    int height = map->height;
+    int above = sim->boundary == boundary_torus ? height - 1 : 0;
+    int below = sim->boundary == boundary_torus ? 0 : height - 1;
+    for(int ty = 0; ty < sim->tiles.rows; ty++){
+        for(int y = ty * TILE_ROWS; ghostRows[ty] && y < (ty + 1) * TILE_ROWS && y < height; y++){
+            fillGhostColumns(sim, y);
+        }
+    }
+    // The guard rows are copies of rows of the map with their ghost columns, so the corners are filled too
+    fillGhostColumns(sim, above);
+    fillGhostColumns(sim, below);
+    memcpy(mapRow(map, -1) - 1, mapRow(map, above) - 1, (map->words + 2) * sizeof(uint64_t));
+    memcpy(mapRow(map, height) - 1, mapRow(map, below) - 1, (map->words + 2) * sizeof(uint64_t));
+}
+
+// Clear the ghost cells filled by fillGhostCells(), outside of the step the guards are zero
+static void clearGhostCells(Simulation * sim, const uint8_t * ghostRows){
+    Bitmap * map = &sim->map;
+    int height = map->height;
+    for(int ty = 0; ty < sim->tiles.rows; ty++){
+        for(int y = ty * TILE_ROWS; ghostRows[ty] && y < (ty + 1) * TILE_ROWS && y < height; y++){
+            clearGhostColumns(map, y);
+        }
+    }
+    clearGhostColumns(map, 0);
+    clearGhostColumns(map, height - 1);
+    memset(mapRow(map, -1) - 1, 0, (map->words + 2) * sizeof(uint64_t));
+    memset(mapRow(map, height) - 1, 0, (map->words + 2) * sizeof(uint64_t));
+}
+
+// Calculate the next state of a row of tiles
+// Only the tiles that changed in the last generation and their neighbours are calculated.
+// The other tiles did not change, so they are the same on both maps, and so are their statistics.
+// The statistics of the calculated tiles are gathered row by row right after the rows are calculated.
+// band: the births, the deaths and the calculated and changed tiles are added to it
+static void stepTileRow(Simulation * sim, int tileRow, CellStats * band){
+    Tiles * tiles = &sim->tiles;
+    int columns = tiles->columns;
+    uint8_t changedColumn[columns], calculate[columns];
+    uint8_t * changed = tiles->changed + (size_t)tileRow * columns;
+    uint8_t * nextChanged = tiles->nextChanged + (size_t)tileRow * columns;
+    uint8_t * dirty = tiles->dirty + (size_t)tileRow * columns;
+    TileStats * stats = tiles->stats + (size_t)tileRow * columns;
+    TileCounters counters;
+    int firstRow = tileRow * TILE_ROWS;
+    int lastRow = firstRow + TILE_ROWS;
+    int first, last;
+    // The last word may hold a ghost cell on the current map
+    uint64_t lastMask = lastWordMask(&sim->map);
+    bool torus = sim->boundary == boundary_torus;
+    
+    if(lastRow > sim->size.height){
+        lastRow = sim->size.height;
+    }
+    // A tile is calculated if it or one of its eight neighbours changed
+    // (on a torus the tiles on the opposite edges are neighbours)
+    for(int tx = 0; tx < columns; tx++){
+        changedColumn[tx] = changed[tx];
+        if(tileRow > 0){
+            changedColumn[tx] |= changed[tx - columns];
+        } else if(torus){
+            changedColumn[tx] |= tiles->changed[(size_t)(tiles->rows - 1) * columns + tx];
+        }
+        if(tileRow < tiles->rows - 1){
+            changedColumn[tx] |= changed[tx + columns];
+        } else if(torus){
+            changedColumn[tx] |= tiles->changed[tx];
+        }
+    }
+    for(int tx = 0; tx < columns; tx++){
+        calculate[tx] = changedColumn[tx] |
+                        (tx > 0 ? changedColumn[tx - 1] : (torus ? changedColumn[columns - 1] : 0)) |
+                        (tx < columns - 1 ? changedColumn[tx + 1] : (torus ? changedColumn[0] : 0));
+        nextChanged[tx] = 0;
+    }
+    
+    // Calculate the runs of neighbouring tiles together
+    for(first = 0; first < columns; first = last){
+        if(!calculate[first]){
+            last = first + 1;
+            continue;
+        }
+        for(last = first; last < columns && calculate[last]; last++);
+        band->calculatedTiles += last - first;
+        // Long runs are calculated in parts, so the counters of a part fit in TileCounters
+        for(int part = first; part < last; part += TILE_COUNTER_WORDS){
+            int partEnd = part + TILE_COUNTER_WORDS < last ? part + TILE_COUNTER_WORDS : last;
+            memset(&counters, 0, sizeof(counters));
+            for(int y = firstRow; y < lastRow; y++){
+                stepRow(sim, y, part, partEnd);
+                // The statistics are gathered while the row is still in the cache
+                sim->gatherStats(mapRow(&sim->map, y), mapRow(&sim->tempMap, y), &counters, y - firstRow,
+                                 part, partEnd, partEnd == columns ? lastMask : ~(uint64_t)0);
+            }
+            for(int tx = part; tx < partEnd; tx++){
+                stats[tx].births = counters.births[tx - part];
+                stats[tx].deaths = counters.deaths[tx - part];
+                stats[tx].columns = counters.columns[tx - part];
+                stats[tx].rows = counters.rows[tx - part];
+            }
+        }
+        for(int tx = first; tx < last; tx++){
+            nextChanged[tx] = stats[tx].births != 0 || stats[tx].deaths != 0;
+            stats[tx].population += stats[tx].births - stats[tx].deaths;
+            band->births += stats[tx].births;
+            band->deaths += stats[tx].deaths;
+            band->changedTiles += nextChanged[tx];
+            dirty[tx] |= nextChanged[tx];
+        }
+    }
+}
+
+// Calculate the next state of a band of tile rows (a job of the thread pool)
+// The rows above and below the band are only read from the current map,
+// and each band writes its own rows on the auxiliary map, so no locking is needed
+static void stepBand(void * context, int band){
+    StepTask * task = (StepTask*)context;
+    int first = band * task->bandHeight;
+    int last = first + task->bandHeight;
+    if(last > task->sim->tiles.rows){
+        last = task->sim->tiles.rows;
+    }
+    task->bands[band] = (CellStats){0};
+    for(int tileRow = first; tileRow < last; tileRow++){
+        stepTileRow(task->sim, tileRow, &task->bands[band]);
+    }
+}
+
+// Count the statistics of the tiles that changed since the last step
+// (the map was modified other than by a step, the modified tiles are marked as changed)
+static void refreshCellStats(Simulation * sim){
+    Tiles * tiles = &sim->tiles;
+    uint64_t lastMask = lastWordMask(&sim->map);
+    uint64_t word;
+    TileStats * stats;
+    int lastRow;
+    
+    sim->cellStatsStale = false;
+    if(sim->universe != NULL){
+        sim->cellStats.population = universePopulation(sim->universe);
+        return;
+    }
+    for(int ty = 0; ty < tiles->rows; ty++){
+        lastRow = (ty + 1) * TILE_ROWS < sim->size.height ? (ty + 1) * TILE_ROWS : sim->size.height;
+        for(int tx = 0; tx < tiles->columns; tx++){
+            if(!tiles->changed[(size_t)ty * tiles->columns + tx]){
+                continue;
+            }
+            stats = &tiles->stats[(size_t)ty * tiles->columns + tx];
+            sim->cellStats.population -= stats->population;
+            stats->population = 0;
+            stats->columns = 0;
+            stats->rows = 0;
+            for(int y = ty * TILE_ROWS; y < lastRow; y++){
+                word = mapRow(&sim->map, y)[tx] & (tx == tiles->columns - 1 ? lastMask : ~(uint64_t)0);
+                stats->population += __builtin_popcountll(word);
+                stats->columns |= word;
+                stats->rows |= (uint64_t)(word != 0) << (y - ty * TILE_ROWS);
+            }
+            sim->cellStats.population += stats->population;
+        }
+    }
+}
+
+// Calculate the next state of the map or the unbounded plane
+// (the next state is calculated on the auxiliary map, then the two maps are exchanged)
+static void advanceGeneration(Simulation * sim){
+    StepTask task;
+    int numOfBands;
+    uint8_t * changed;
+    bool ghosts = sim->boundary != boundary_dead && sim->size.width > 0 && sim->size.height > 0;
+    CellStats * stats = &sim->cellStats;
+    
+    sim->periodFound = false;
+    // The population is updated by the births and deaths, so it must be up to date before the step
+    if(sim->cellStatsStale){
+        refreshCellStats(sim);
+    }
+    stats->births = 0;
+    stats->deaths = 0;
+    stats->calculatedTiles = 0;
+    stats->changedTiles = 0;
+    if(sim->universe != NULL){
+        stepUniverse(sim->universe, sim->pool, sim->rule, stats);
+        stats->population += stats->births - stats->deaths;
+        if(sim->period != NULL){
+            sim->periodFound = recordUniversePeriod(sim->period, sim->universe);
+        }
+        return;
+    }
+    uint8_t ghostRows[sim->tiles.rows + 1];
+    if(ghosts){
+        findGhostTileRows(sim, ghostRows);
+        fillGhostCells(sim, ghostRows);
+    }
+    task.sim = sim;
+    sim->stepWords = wordKernel(sim->kernel, sim->rule);
+    sim->gatherStats = statsKernel();
+    if(sim->pool == NULL || sim->pool->numOfThreads == 1 ||
+       (long long)sim->map.words * sim->size.height < MIN_PARALLEL_WORDS){
+        numOfBands = 1;
+    } else {
+        numOfBands = sim->pool->numOfThreads * BANDS_PER_THREAD;
+    }
+    task.bandHeight = (sim->tiles.rows + numOfBands - 1) / numOfBands;
+    numOfBands = (sim->tiles.rows + task.bandHeight - 1) / task.bandHeight;
+    CellStats bands[numOfBands];
+    task.bands = bands;
+    if(numOfBands == 1){
+        stepBand(&task, 0);
+    } else {
+        runParallel(sim->pool, stepBand, &task, numOfBands);
+    }
+    
+    if(ghosts){
+        clearGhostCells(sim, ghostRows);
+    }
+    // The partial sums of the bands
+    for(int i = 0; i < numOfBands; i++){
+        stats->births += bands[i].births;
+        stats->deaths += bands[i].deaths;
+        stats->calculatedTiles += bands[i].calculatedTiles;
+        stats->changedTiles += bands[i].changedTiles;
+    }
+    stats->population += stats->births - stats->deaths;
+    // The checkpoints keep the current content of the changed tiles
+    // (after the bands are done: the checkpoints are shared by the threads)
+    changed = sim->tiles.nextChanged;
+    for(int ty = 0; ty < sim->tiles.rows; ty++){
+        for(int tx = 0; tx < sim->tiles.columns; tx++, changed++){
+            if(*changed){
+                preserveTile(&sim->checkpoints, &sim->map, tx, ty);
+            }
+        }
+    }
+    changed = sim->tiles.changed;
+    sim->tiles.changed = sim->tiles.nextChanged;
+    sim->tiles.nextChanged = changed;
+    if(sim->history != NULL){
+        recordGeneration(sim->history, &sim->map, &sim->tempMap, sim->tiles.changed, sim->tiles.columns, sim->tiles.rows);
+    }
+    swapMaps(&sim->map, &sim->tempMap);
+    if(sim->period != NULL){
+        sim->periodFound = recordMapPeriod(sim->period, &sim->map, sim->tiles.changed, sim->tiles.columns, sim->tiles.rows);
+    }
+}
+
+// Advance the simulation to the next state
+void cycle(Simulation * sim){
+    Uint64 start = SDL_GetPerformanceCounter();
+    advanceGeneration(sim);
+    stopTimer(&sim->stats.step, start);
+    sim->stats.generations++;
+}
+
+// Advance the unbounded plane by 2^fastForwardExponent generations with HashLife
+// (HashLife works on an unbounded plane, so a bounded map with its dead, torus or mirror edges is not fast-forwarded)
+// Return: TRUE on success, FALSE if HashLife is disabled or the simulation uses a bounded map
+bool fastForward(Simulation * sim){
+    Uint64 start = SDL_GetPerformanceCounter();
+    if(sim->hashlife == NULL || sim->universe == NULL){
+        return false;
+    }
+    // The jump is not recorded generation by generation
+    forgetPastGenerations(sim);
+    setHashLifeRule(sim->hashlife, sim->rule);
+    universeToHashLife(sim->universe, sim->hashlife);
+    advanceHashLife(sim->hashlife, sim->fastForwardExponent);
+    hashLifeToUniverse(sim->hashlife, sim->universe);
+    stopTimer(&sim->stats.step, start);
+    sim->stats.generations += 1LL << sim->fastForwardExponent;
+    return true;
+}
+
+// Move the map to another generation recorded in the history
+// (relative: number of generations to move, negative to move backward)
+// Return: TRUE on success, FALSE if the generation is not in the history
+bool seekGeneration(Simulation * sim, long long relative){
+    History * h = sim->history;
+    long long generation;
+    if(h == NULL || sim->universe != NULL){
+        return false;
+    }
+    // A move past the ends of the history stops at the end
+    generation = h->generation + relative;
+    if(generation < oldestGeneration(h)){
+        generation = oldestGeneration(h);
+    } else if(generation > h->latest){
+        generation = h->latest;
+    }
+    if(generation == h->generation){
+        return false;
+    }
+    if(sim->period != NULL){
+        resetPeriod(sim->period);
+    }
+    sim->cellStatsStale = true;
+    return seekHistory(h, generation, &sim->map, &sim->checkpoints, sim->tiles.changed, sim->tiles.dirty,
+                       sim->tiles.columns, sim->tiles.rows);
+}
+
+// Change the rule of the simulation
+// (the recorded generations and the detected period belong to the previous rule, they are dropped)
+void setRule(Simulation * sim, Rule rule){
+    char name[RULE_NAME_LENGTH];
+    if(sameRule(sim->rule, rule)){
+        return;
+    }
+    sim->rule = rule;
+    forgetPastGenerations(sim);
+    ruleName(rule, name);
+    printf("Rule: %s%s\n", name, specializedRule(rule) ? "" : " (generic kernel)");
+}
+
+// Get the statistics of the cells gathered by the last step
+// (after the map was modified other than by a step, the tiles that changed are counted again first)
+// Return: CellStats
+CellStats queryCellStats(Simulation * sim){
+    if(sim->cellStatsStale){
+        refreshCellStats(sim);
+    }
+    return sim->cellStats;
+}
+
+// Get the smallest rectangle that contains every active cell
+// (it is found from the statistics of the tiles, without reading the cells)
+// Return: TRUE if there are active cells, FALSE if the map is empty
+bool populationBounds(Simulation * sim, int * x, int * y, int * width, int * height){
+    Tiles * tiles = &sim->tiles;
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    int left, right, top, bottom;
+    const TileStats * stats;
+    
+    if(sim->universe != NULL){
+        return universeBounds(sim->universe, x, y, width, height);
+    }
+    if(sim->cellStatsStale){
+        refreshCellStats(sim);
+    }
+    for(int ty = 0; ty < tiles->rows; ty++){
+        for(int tx = 0; tx < tiles->columns; tx++){
+            stats = &tiles->stats[(size_t)ty * tiles->columns + tx];
+            if(stats->population == 0){
+                continue;
+            }
+            left = tx * WORD_BITS + __builtin_ctzll(stats->columns);
+            right = tx * WORD_BITS + WORD_BITS - 1 - __builtin_clzll(stats->columns);
+            top = ty * TILE_ROWS + __builtin_ctzll(stats->rows);
+            bottom = ty * TILE_ROWS + TILE_ROWS - 1 - __builtin_clzll(stats->rows);
+            if(maxX < 0){
+                minX = left;
+                maxX = right;
+                minY = top;
+                maxY = bottom;
+            } else {
+                minX = left < minX ? left : minX;
+                maxX = right > maxX ? right : maxX;
+                minY = top < minY ? top : minY;
+                maxY = bottom > maxY ? bottom : maxY;
+            }
+        }
+    }
+    if(maxX < 0){
+        return false;
+    }
+    *x = minX;
+    *y = minY;
+    *width = maxX - minX + 1;
+    *height = maxY - minY + 1;
+    return true;
+}
+
+// Get the statistics of a tile of the map (TILE_ROWS rows of a word)
+// (on the unbounded plane: the 64x64 tile at the given tile position)
+// Return: TileStats (zero outside of the map or where no tile is allocated)
+TileStats queryTileStats(Simulation * sim, int tileX, int tileY){
+    const Tile * tile;
+    if(sim->universe != NULL){
+        tile = findTile(sim->universe, tileX, tileY);
+        return tile == NULL ? (TileStats){0} : tile->stats;
+    }
+    if(tileX < 0 || tileX >= sim->tiles.columns || tileY < 0 || tileY >= sim->tiles.rows){
+        return (TileStats){0};
+    }
+    if(sim->cellStatsStale){
+        refreshCellStats(sim);
+    }
+    return sim->tiles.stats[(size_t)tileY * sim->tiles.columns + tileX];
+}
+
+// Drop the recorded generations and restart the period detection
+// (it must be called when the map is modified other than by a step)
+void forgetPastGenerations(Simulation * sim){
+    if(sim->history != NULL){
+        clearHistory(sim->history);
+    }
+    if(sim->period != NULL){
+        resetPeriod(sim->period);
+    }
+    // The modified tiles are marked as changed, their statistics are counted again when they are needed
+    sim->cellStatsStale = true;
+}
+
+// Print the period detected in the last generation
+void printPeriod(Simulation * sim){
+    if(sim->period->period == 1){
+        printf("The map is static since generation %lld\n", sim->period->periodStart);
+    } else {
+        printf("The map is periodic with period %d since generation %lld\n", sim->period->period, sim->period->periodStart);
+    }
+    printf("(generations are counted from the last change of the map)\n");
+}
+
+// Get the state of a cell of the map (or the unbounded plane)
+// Return: 1 if the cell is active, 0 otherwise
+int getSimulationCell(Simulation * sim, int x, int y){
+    if(sim->universe != NULL){
+        return getUniverseCell(sim->universe, x, y);
+    }
+    return getCell(&sim->map, x, y);
+}
+
+// Set the state of a cell edited by the user
+void editCell(Simulation * sim, int x, int y, int state){
+    forgetPastGenerations(sim);
+    if(sim->universe != NULL){
+        setUniverseCell(sim->universe, x, y, state);
+        return;
+    }
+    preserveTile(&sim->checkpoints, &sim->map, x / WORD_BITS, y / TILE_ROWS);
+    setCell(&sim->map, x, y, state);
+    sim->tiles.changed[(size_t)(y / TILE_ROWS) * sim->tiles.columns + x / WORD_BITS] = 1;
+    sim->tiles.dirty[(size_t)(y / TILE_ROWS) * sim->tiles.columns + x / WORD_BITS] = 1;
+}
+
+// Mark every tile as changed
+// (it must be called after the map was modified without editCell())
+void markAllTilesChanged(Simulation * sim){
+    memset(sim->tiles.changed, 1, (size_t)sim->tiles.columns * sim->tiles.rows);
+    memset(sim->tiles.dirty, 1, (size_t)sim->tiles.columns * sim->tiles.rows);
+}
+
+// Update the population pyramid for the tiles that changed since the last update
+void updatePyramid(Simulation * sim){
+    uint8_t * dirty = sim->tiles.dirty;
+    for(int ty = 0; ty < sim->tiles.rows; ty++){
+        for(int tx = 0; tx < sim->tiles.columns; tx++, dirty++){
+            if(*dirty){
+                updatePyramidTile(&sim->pyramid, &sim->map, tx, ty);
+                *dirty = 0;
+            }
+        }
+    }
+}
+
+// Set the number of threads used to calculate the next state
+// (0: number of processor cores)
+void setThreadCount(Simulation * sim, int threads){
+    if(threads <= 0){
+        threads = SDL_GetCPUCount();
+    }
+    threadpool_destroy(sim->pool);
+    sim->pool = NULL;
+    if(threads > 1){
+        sim->pool = threadpool_init(threads);
+    }
+}
+
+// Save the current map as a checkpoint
+// (checkpoint DEFAULT_CHECKPOINT is restored by the Reset button)
+void saveCheckpoint(Simulation * sim, int slot){
+    if(sim->universe != NULL){
+        // The tiles of the unbounded plane are only allocated where there is activity, so it is copied
+        if(sim->savedUniverses[slot] == NULL){
+            sim->savedUniverses[slot] = universe_init();
+        }
+        copyUniverse(sim->savedUniverses[slot], sim->universe);
+        return;
+    }
+    takeCheckpoint(&sim->checkpoints, slot);
+}
+
+// Restore the map saved by a checkpoint
+// Return: TRUE on success, FALSE if the checkpoint was not taken
+bool restoreCheckpoint(Simulation * sim, int slot){
+    if(sim->universe != NULL ? sim->savedUniverses[slot] == NULL : !sim->checkpoints.slots[slot].used){
+        return false;
+    }
+    forgetPastGenerations(sim);
+    if(sim->universe != NULL){
+        copyUniverse(sim->universe, sim->savedUniverses[slot]);
+        return true;
+    }
+    return restoreCheckpointTiles(&sim->checkpoints, slot, &sim->map, sim->tiles.changed, sim->tiles.dirty);
+}
+
+// Get the speed at a position of the speed slider
+// The slider has a logarithmic scale from 1 to MAX_SPEED generations per second,
+// its right end selects the unlimited mode
+// position: 0 (left end) - 1 (right end)
+// Return: Speed rounded to two significant digits, or SPEED_UNLIMITED
+int sliderSpeed(double position){
+    double scale = 1;
+    if(position >= 1 - SPEED_SLIDER_UNLIMITED){
+        return SPEED_UNLIMITED;
+    }
+    if(position < 0){
+        position = 0;
+    }
+    double speed = pow(MAX_SPEED, position / (1 - SPEED_SLIDER_UNLIMITED));
+    while(speed >= 100){
+        speed /= 10;
+        scale *= 10;
+    }
+    return (int)(floor(speed + 0.5) * scale);
+}
+
+// Get the position of a speed on the speed slider
+// Return: 0 (left end) - 1 (right end)
+double speedSliderPosition(int speed){
+    if(speed == SPEED_UNLIMITED){
+        return 1;
+    }
+    if(speed > MAX_SPEED){
+        speed = MAX_SPEED;
+    }
+    return log10(speed) / log10(MAX_SPEED) * (1 - SPEED_SLIDER_UNLIMITED);
+}
+
+// Set simulation speed given by the speed slider
+void setSpeedSlider(Simulation * sim){
+    int mouseX, mouseY;
+    SDL_GetMouseState(&mouseX, &mouseY);
+    // The center of the knob follows the cursor
+    sim->speed = sliderSpeed((mouseX - speedBar.x - SPEED_KNOB_SIZE / 2) / (double)(speedBar.w - SPEED_KNOB_SIZE));
+}
+
+// Number of bytes allocated by the simulation
+// (the maps, the change tracking, the pyramid, the checkpoints, the history, the unbounded plane and the HashLife nodes)
+// Return: Size in bytes
+size_t simulationSize(const Simulation * sim){
+    size_t size = bitmapSize(&sim->map) + bitmapSize(&sim->tempMap) +
+                  ((size_t)sim->tiles.columns * sim->tiles.rows + 1) * (3 + sizeof(TileStats)) +
+                  pyramidSize(&sim->pyramid) + checkpointsSize(&sim->checkpoints);
+    if(sim->history != NULL){
+        size += historySize(sim->history);
+    }
+    if(sim->universe != NULL){
+        size += universeSize(sim->universe);
+    }
+    for(int i = 0; i < MAX_CHECKPOINTS; i++){
+        if(sim->savedUniverses[i] != NULL){
+            size += universeSize(sim->savedUniverses[i]);
+        }
+    }
+    if(sim->hashlife != NULL){
+        size += hashLifeSize(sim->hashlife);
+    }
+    return size;
+}
+
+// Initialize the simulation structure
+// Return: Simulation
+Simulation simulation_init(int width, int height){
+    Simulation sim;
+    sim.size = (Size){width, height};
+    sim.offset = (Offset){0,0};
+    sim.running = false;
+    sim.firstStart = true;
+    sim.command = no_command;
+    sim.speed = 1;
+    sim.zoom = 11;
+    sim.kernel = bestKernel();
+    sim.rule = RULE_CONWAY;
+    sim.boundary = boundary_dead;
+    sim.stepWords = NULL;
+    sim.pool = NULL;
+    sim.hashlife = NULL;
+    sim.fastForwardExponent = 0;
+    sim.universe = NULL;
+    for(int i = 0; i < MAX_CHECKPOINTS; i++){
+        sim.savedUniverses[i] = NULL;
+    }
+    sim.mapFile = "map.bin";
+    sim.history = NULL;
+    sim.period = NULL;
+    sim.periodFound = false;
+    sim.stopWhenPeriodic = false;
+    sim.stats = stats_init();
+    sim.cellStats = (CellStats){0};
+    // Every tile is marked as changed, so the first query counts them
+    sim.cellStatsStale = true;
+    sim.gatherStats = NULL;
+    sim.map = bitmap_init(width, height);
+    sim.tempMap = bitmap_init(width, height);
+    sim.tiles.columns = sim.map.words;
+    sim.tiles.rows = (height + TILE_ROWS - 1) / TILE_ROWS;
+    // One extra byte, so an empty map also gets a valid allocation
+    sim.tiles.changed = malloc((size_t)sim.tiles.columns * sim.tiles.rows + 1);
+    sim.tiles.nextChanged = calloc((size_t)sim.tiles.columns * sim.tiles.rows + 1, 1);
+    sim.tiles.dirty = malloc((size_t)sim.tiles.columns * sim.tiles.rows + 1);
+    sim.tiles.stats = calloc((size_t)sim.tiles.columns * sim.tiles.rows + 1, sizeof(TileStats));
+    if(sim.tiles.changed == NULL || sim.tiles.nextChanged == NULL || sim.tiles.dirty == NULL || sim.tiles.stats == NULL){
+        notEnoughMemory();
+    }
+    sim.pyramid = pyramid_init(width, height);
+    sim.checkpoints = checkpoints_init(sim.tiles.columns, sim.tiles.rows);
+    markAllTilesChanged(&sim);
+    return sim;
+}
+
+// Frees the memory allocated by the simulation
+void simulation_free(Simulation * sim){
+    threadpool_destroy(sim->pool);
+    sim->pool = NULL;
+    hashlife_free(sim->hashlife);
+    sim->hashlife = NULL;
+    history_free(sim->history);
+    sim->history = NULL;
+    period_free(sim->period);
+    sim->period = NULL;
+    for(int i = 0; i < MAX_CHECKPOINTS; i++){
+        universe_free(sim->savedUniverses[i]);
+        sim->savedUniverses[i] = NULL;
+    }
+    universe_free(sim->universe);
+    sim->universe = NULL;
+    checkpoints_free(&sim->checkpoints);
+    pyramid_free(&sim->pyramid);
+    free(sim->tiles.stats);
+    free(sim->tiles.dirty);
+    free(sim->tiles.nextChanged);
+    free(sim->tiles.changed);
+    bitmap_free(&sim->tempMap);
+    bitmap_free(&sim->map);
+}
+
+// Replace the map with an empty one of the given dimensions
+// (the kernel, the rule, the boundary mode, the worker threads, the HashLife node cache, the history, the period detector,
+// the map file and the performance counters are kept)
+void simulation_resize(Simulation * sim, int width, int height){
+    step_kernel kernel = sim->kernel;
+    Rule rule = sim->rule;
+    boundary_mode boundary = sim->boundary;
+    ThreadPool * pool = sim->pool;
+    HashLife * hashlife = sim->hashlife;
+    int fastForwardExponent = sim->fastForwardExponent;
+    const char * mapFile = sim->mapFile;
+    History * history = sim->history;
+    PeriodDetector * period = sim->period;
+    bool stopWhenPeriodic = sim->stopWhenPeriodic;
+    Stats stats = sim->stats;
+    // Keep the worker threads, the HashLife node cache, the history and the period detector for the new simulation
+    sim->pool = NULL;
+    sim->hashlife = NULL;
+    sim->history = NULL;
+    sim->period = NULL;
+    simulation_free(sim);
+    *sim = simulation_init(width, height);
+    sim->kernel = kernel;
+    sim->rule = rule;
+    sim->boundary = boundary;
+    sim->pool = pool;
+    sim->hashlife = hashlife;
+    sim->fastForwardExponent = fastForwardExponent;
+    sim->mapFile = mapFile;
+    sim->history = history;
+    sim->period = period;
+    sim->stopWhenPeriodic = stopWhenPeriodic;
+    sim->stats = stats;
+    forgetPastGenerations(sim);
+}
+
+// Initialize a simulation on an unbounded plane
+// Return: Simulation
+Simulation simulation_initUnbounded(){
+    Simulation sim = simulation_init(0, 0);
+    sim.universe = universe_init();
+    return sim;
+}
+
+// Prompt the user to enter the dimensions and then
+// create the simulation
+// Return: Simulation
+Simulation simulation_create(){
+    int width, height;
+    printf("Enter the dimensions!\n");
+    printf("Width: ");
+    scanf("%d", &width);
+    printf("Height: ");
+    scanf("%d", &height);
+    
+    return simulation_init(width, height);
 }
\ No newline at end of file
@@ -1,96 +1,227 @@
-#ifndef SIMULATION_H
-#define SIMULATION_H
-
-#include <SDL2/SDL.h>
-#include <stdbool.h>
-
-// Dimensions of the simulation
-typedef struct Size{
-    int width;
-    int height;
-} Size;
-
-// Offset for drawing operations
-typedef struct Offset{
-    int x;
-    int y;
-} Offset;
-
-// Delayed commands that must only be executed at
-// the end of a simulation loop
-// (it is used to load a new simulation)
-typedef enum command{
-    no_command,
-    load
-} command;
-
-// Cell state
-enum cell_state{
-    empty,  // Inactive (empty)
-    active  // Active
-};
-
-// Simulation properties
-typedef struct Simulation{
-    Size size;         // Number of cells in a row and in a column
-    Offset offset;     // Offset of the map from the top left corner
-    int speed;         // Number of steps in the simulation in a second
-    bool running;      // The simulation is running
-    bool firstStart;   // Is this the first start
-                       // (If it is true, then it should save the default map before playing or stepping)
-    command command;   // Delayed commands that must only be executed at
-                       // the end of a simulation loop, because it modifies internal data structures
-    int zoom;          // Level of zoom ( the size of a cell in pixels )
-    int ** map;        // Visible map
-    int ** tempMap;    // Auxiliary map to calculate next state
-    int ** defaultMap; // Default state ( before the simulation is started )
-} Simulation;
-
-// Clear the map
-void clearMap(Simulation * sim, int ** map);
-
-// Calculate how many neighbours the given cell has
-void recordNeighbourCells(Simulation * sim, int cellX, int cellY);
-
-// To calculate the next simulation state,
-// count how many neighbours each cell has
-void countNeighbourCells(Simulation * sim);
-
-// Advance the simulation to the next state
-void cycle(Simulation * sim);
-
-// Copy the content of the map to another
-// (it is used to calculate next state on an auxiliary map)
-void copyMap(Simulation * sim, int ** dst, int ** src);
-
-// Save current map as checkpoint
-void setAsDefaultMap(Simulation * sim);
-
-// Restore checkpoint
-void restoreDefaultMap(Simulation * sim);
-
-// Set simulation speed given by the speed slider
-void setSpeedSlider(Simulation * sim);
-
-// Timer to create continuous simulation
-Uint32 simulationStepper(Uint32 interval, void * param);
-
-// Initialize the simulation structure
-// Return: Simulation
-Simulation simulation_init(int width, int height);
-
-// Frees the memory allocated by the simulation
-void simulation_free(Simulation * sim);
-
-// Frees the simulation structure and stops the SDL timer
-void simulation_destroy(Simulation * sim, SDL_TimerID timer);
-
-// Initialize a new simulation with the given dimensions
-void simulation_reinit(Simulation * sim, SDL_TimerID * timer, int width, int height);
-
-// Prompt the user to enter the dimensions and then
-// create the simulation
-// Return: Simulation
-Simulation simulation_create();
-
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "bitmap.h"
+#include "kernel.h"
+#include "threadPool.h"
+#include "hashlife.h"
+#include "universe.h"
+#include "pyramid.h"
+#include "checkpoint.h"
+#include "history.h"
+#include "period.h"
+#include "stats.h"
+
+// Highest speed of the simulation that is paced (generations per second)
+#define MAX_SPEED 100000
+
+// Speed of the unlimited mode: the generations are calculated as fast as possible
+#define SPEED_UNLIMITED 0
+
+// Part of the speed slider on its right end that selects the unlimited mode
+#define SPEED_SLIDER_UNLIMITED 0.1
+
+// Dimensions of the simulation
+typedef struct Size{
+    int width;
+    int height;
+} Size;
+
+// Offset for drawing operations
+typedef struct Offset{
+    int x;
+    int y;
+} Offset;
+
+// Delayed commands that must only be executed at
+// the end of a simulation loop
+// (it is used to load a new simulation)
+typedef enum command{
+    no_command,
+    load
+} command;
+
+// Cell state
+enum cell_state{
+    empty,  // Inactive (empty)
+    active  // Active
+};
+
+// Treatment of the cells outside of the bounded map
+typedef enum boundary_mode{
+    boundary_dead,   // The cells outside of the map are inactive
+    boundary_torus,  // The map wraps around, the opposite edges are neighbours
+    boundary_mirror  // The map is reflected on its edges, the cells outside are copies of the edge cells
+} boundary_mode;
+
+// Lowest level of zoom (a pixel shows 2^12 x 2^12 cells)
+#define MIN_ZOOM -12
+
+// Change tracking of the tiles of the map
+typedef struct Tiles{
+    int columns;            // Number of tiles in a row
+    int rows;               // Number of tiles in a column
+    uint8_t * changed;      // The tile changed in the last generation (or it was edited)
+    uint8_t * nextChanged;  // The tile changes in the generation being calculated
+    uint8_t * dirty;        // The tile changed since the population pyramid was last updated
+    TileStats * stats;      // Statistics of the cells of the tile (updated when the tile is calculated)
+} Tiles;
+
+// Simulation properties
+typedef struct Simulation{
+    Size size;         // Number of cells in a row and in a column
+    Offset offset;     // Offset of the map from the top left corner
+    int speed;         // Number of steps in the simulation in a second (SPEED_UNLIMITED: as fast as possible)
+    bool running;      // The simulation is running
+    bool firstStart;   // Is this the first start
+                       // (If it is true, then it should save the default map before playing or stepping)
+    command command;   // Delayed commands that must only be executed at
+                       // the end of a simulation loop, because it modifies internal data structures
+    int zoom;          // Level of zoom ( the size of a cell in pixels is zoom + 1,
+                       // below 0 a pixel shows a block of 2^-zoom x 2^-zoom cells )
+    step_kernel kernel; // Implementation of the simulation step
+    Rule rule;          // Birth and survival conditions of the cells
+    boundary_mode boundary; // Treatment of the cells outside of the map (the unbounded plane has no edges)
+    word_kernel stepWords; // Word kernel of the kernel and the rule (selected at the beginning of every step)
+    stats_kernel gatherStats; // Kernel that gathers the statistics of the calculated rows
+    ThreadPool * pool; // Threads that calculate the next state (NULL: single threaded)
+    Bitmap map;        // Visible map
+    Bitmap tempMap;    // Auxiliary map to calculate next state
+    Checkpoints checkpoints; // Saved states of the map (checkpoint 0 is the state before the simulation is started)
+    Tiles tiles;       // Tiles that changed in the last generation
+    Pyramid pyramid;   // Population counts of the map used when zoomed out (updated by updatePyramid())
+    HashLife * hashlife;     // HashLife universe used to fast-forward (NULL: disabled)
+    int fastForwardExponent; // Fast-forward advances the map by 2^fastForwardExponent generations
+    Universe * universe;        // Unbounded plane (NULL: the simulation uses the map of the given size)
+    Universe * savedUniverses[MAX_CHECKPOINTS]; // Checkpoints of the unbounded plane (NULL: not taken)
+    const char * mapFile;       // File used by the Save and Load buttons
+    History * history;          // Recent generations of the map for stepping backward (NULL: disabled)
+    PeriodDetector * period;    // Detects when the map becomes static or periodic (NULL: disabled)
+    bool periodFound;           // The map became static or periodic in the last generation
+    bool stopWhenPeriodic;      // The simulation thread stops the simulation when the map becomes periodic
+    Stats stats;                // Time spent calculating generations and saving and loading maps
+    CellStats cellStats;        // Statistics of the cells gathered by the last step (see queryCellStats())
+    bool cellStatsStale;        // The map was modified other than by a step since the statistics were gathered
+} Simulation;
+
+// Calculate how many neighbours the given cell has
+// (the ghost cells around the map are read without bounds checks, they are filled by the step)
+// Return: Number of active neighbours
+int countNeighbourCells(Simulation * sim, int cellX, int cellY);
+
+// Calculate the next state of the words [first, last) of a row cell by cell
+void stepRowScalar(Simulation * sim, int y, int first, int last);
+
+// Calculate the next state of the words [first, last) of a row on the auxiliary map
+// with the selected kernel
+void stepRow(Simulation * sim, int y, int first, int last);
+
+// Advance the simulation to the next state
+void cycle(Simulation * sim);
+
+// Advance the unbounded plane by 2^fastForwardExponent generations with HashLife
+// (HashLife works on an unbounded plane, so a bounded map with its dead, torus or mirror edges is not fast-forwarded)
+// Return: TRUE on success, FALSE if HashLife is disabled or the simulation uses a bounded map
+bool fastForward(Simulation * sim);
+
+// Move the map to another generation recorded in the history
+// (relative: number of generations to move, negative to move backward)
+// Return: TRUE on success, FALSE if the generation is not in the history
+bool seekGeneration(Simulation * sim, long long relative);
+
+// Change the rule of the simulation
+// (the recorded generations and the detected period belong to the previous rule, they are dropped)
+void setRule(Simulation * sim, Rule rule);
+
+// Get the statistics of the cells gathered by the last step
+// (after the map was modified other than by a step, the tiles that changed are counted again first)
+// Return: CellStats
+CellStats queryCellStats(Simulation * sim);
+
+// Get the smallest rectangle that contains every active cell
+// (it is found from the statistics of the tiles, without reading the cells)
+// Return: TRUE if there are active cells, FALSE if the map is empty
+bool populationBounds(Simulation * sim, int * x, int * y, int * width, int * height);
+
+// Get the statistics of a tile of the map (TILE_ROWS rows of a word)
+// (on the unbounded plane: the 64x64 tile at the given tile position)
+// Return: TileStats (zero outside of the map or where no tile is allocated)
+TileStats queryTileStats(Simulation * sim, int tileX, int tileY);
+
+// Drop the recorded generations and restart the period detection
+// (it must be called when the map is modified other than by a step)
+void forgetPastGenerations(Simulation * sim);
+
+// Print the period detected in the last generation
+void printPeriod(Simulation * sim);
+
+// Get the state of a cell of the map (or the unbounded plane)
+// Return: 1 if the cell is active, 0 otherwise
+int getSimulationCell(Simulation * sim, int x, int y);
+
+// Set the state of a cell edited by the user
+void editCell(Simulation * sim, int x, int y, int state);
+
+// Mark every tile as changed
+// (it must be called after the map was modified without editCell(),
+// and the checkpoints must be updated with preserveAllTiles() before the map is modified)
+void markAllTilesChanged(Simulation * sim);
+
+// Update the population pyramid for the tiles that changed since the last update
+void updatePyramid(Simulation * sim);
+
+// Set the number of threads used to calculate the next state
+// (0: number of processor cores)
+void setThreadCount(Simulation * sim, int threads);
+
+// Save the current map as a checkpoint
+// (checkpoint DEFAULT_CHECKPOINT is restored by the Reset button)
+void saveCheckpoint(Simulation * sim, int slot);
+
+// Restore the map saved by a checkpoint
+// Return: TRUE on success, FALSE if the checkpoint was not taken
+bool restoreCheckpoint(Simulation * sim, int slot);
+
+// Get the speed at a position of the speed slider
+// The slider has a logarithmic scale from 1 to MAX_SPEED generations per second,
+// its right end selects the unlimited mode
+// position: 0 (left end) - 1 (right end)
+// Return: Speed rounded to two significant digits, or SPEED_UNLIMITED
+int sliderSpeed(double position);
+
+// Get the position of a speed on the speed slider
+// Return: 0 (left end) - 1 (right end)
+double speedSliderPosition(int speed);
+
+// Set simulation speed given by the speed slider
+void setSpeedSlider(Simulation * sim);
+
+// Number of bytes allocated by the simulation
+// (the maps, the change tracking, the pyramid, the checkpoints, the history, the unbounded plane and the HashLife nodes)
+// Return: Size in bytes
+size_t simulationSize(const Simulation * sim);
+
+// Initialize the simulation structure
+// Return: Simulation
+Simulation simulation_init(int width, int height);
+
+// Frees the memory allocated by the simulation
+void simulation_free(Simulation * sim);
+
+// Replace the map with an empty one of the given dimensions
+// (the kernel, the rule, the boundary mode, the worker threads, the HashLife node cache, the history, the period detector,
+// the map file and the performance counters are kept)
+void simulation_resize(Simulation * sim, int width, int height);
+
+// Initialize a simulation on an unbounded plane
+// Return: Simulation
+Simulation simulation_initUnbounded();
+
+// Prompt the user to enter the dimensions and then
+// create the simulation
+// Return: Simulation
+Simulation simulation_create();
+
 #endif
\ No newline at end of file
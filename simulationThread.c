@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <string.h>
+#include "error.h"
+#include "simulationThread.h"
+
+// Copy the current state of the simulation to the snapshot
+// Only the part of the map the renderer samples is copied, so a frame costs the size of the view, not of the board.
+// level: the view samples blocks of 2^level x 2^level cells (from the pyramid on the stored levels, which is brought up to date)
+// view: blocks sampled by the view
+static void takeSnapshot(Snapshot * snapshot, Simulation * sim, int level, SDL_Rect view){
+    int firstRow, lastRow, firstWord, lastWord;
+    
+    snapshot->hasPyramid = false;
+    snapshot->region = (SDL_Rect){0, 0, 0, 0};
+    snapshot->stats = sim->stats;
+    snapshot->cells = queryCellStats(sim);
+    snapshot->memory = simulationSize(sim);
+    if(sim->universe != NULL){
+        copyUniverse(snapshot->universe, sim->universe);
+        return;
+    }
+    // A map of different size was loaded since the last snapshot
+    if(snapshot->map.width != sim->map.width || snapshot->map.height != sim->map.height){
+        bitmap_free(&snapshot->map);
+        snapshot->map = bitmap_init(sim->map.width, sim->map.height);
+    }
+    if(level >= PYRAMID_FIRST_LEVEL){
+        updatePyramid(sim);
+        copyPyramidBlocks(&snapshot->pyramid, &sim->pyramid, level, view.x, view.y, view.w, view.h);
+        snapshot->hasPyramid = true;
+        return;
+    }
+    // The rows of the sampled cells, and their words with the word after them (a row of texels can start inside a word)
+    firstRow = view.y * (1 << level);
+    lastRow = (view.y + view.h) * (1 << level);
+    firstWord = (view.x * (1 << level)) >> 6;
+    lastWord = (((view.x + view.w) * (1 << level) - 1) >> 6) + 2;
+    firstRow = firstRow > 0 ? firstRow : 0;
+    lastRow = lastRow < sim->map.height ? lastRow : sim->map.height;
+    firstWord = firstWord > 0 ? firstWord : 0;
+    lastWord = lastWord < sim->map.words ? lastWord : sim->map.words;
+    if(firstRow >= lastRow || firstWord >= lastWord){
+        return;
+    }
+    snapshot->region = (SDL_Rect){firstWord, firstRow, lastWord - firstWord, lastRow - firstRow};
+    for(int r = firstRow; r < lastRow; r++){
+        memcpy(mapRow(&snapshot->map, r) + firstWord, mapRow(&sim->map, r) + firstWord,
+               (size_t)(lastWord - firstWord) * sizeof(uint64_t));
+    }
+}
+
+// Notify the event loop that a new generation can be drawn
+static void pushFrameEvent(){
+    SDL_Event event;
+    SDL_UserEvent userevent;
+
+    userevent.type = SDL_USEREVENT;
+    userevent.code = 1;
+    userevent.data1 = NULL;
+    userevent.data2 = NULL;
+
+    event.type = SDL_USEREVENT;
+    event.user = userevent;
+
+    SDL_PushEvent(&event);
+}
+
+// Copy the new generation to the back snapshot if the renderer already took the previous one
+// (called by the worker while it holds the lock of the simulation)
+static void publishGeneration(SimulationThread * st){
+    bool backReady;
+    SDL_LockMutex(st->swapLock);
+    backReady = st->backReady;
+    SDL_UnlockMutex(st->swapLock);
+    if(backReady){
+        // The renderer did not draw the previous generation yet, it is skipped
+        return;
+    }
+    takeSnapshot(&st->snapshots[1 - st->front], st->sim, st->level, st->view);
+    SDL_LockMutex(st->swapLock);
+    st->backReady = true;
+    SDL_UnlockMutex(st->swapLock);
+    pushFrameEvent();
+}
+
+// Time when a generation is due
+// start: time of generation 0 of the pace, paced: number of generations since the start
+// Return: Value of the performance counter
+static Uint64 dueTime(Uint64 start, long long paced, int speed, Uint64 frequency){
+    return start + (Uint64)((double)paced * frequency / speed);
+}
+
+// Calculate the next generation and handle a detected period
+// Return: TRUE if the simulation is still running, FALSE if it stopped at a period
+static bool stepGeneration(SimulationThread * st){
+    cycle(st->sim);
+    if(st->sim->periodFound){
+        printPeriod(st->sim);
+        if(st->sim->stopWhenPeriodic){
+            st->sim->running = false;
+        }
+    }
+    return st->sim->running;
+}
+
+// Advance the simulation while it is running, paced by its speed (generations per second)
+// The due time of every generation is counted from the start of the pace, so the speed is
+// exact on average even if the waits are rounded to milliseconds. The generations that are
+// due at a wakeup are calculated in a batch, so speeds above the frame rate publish one
+// generation per batch. In the unlimited mode the batches follow each other without waiting.
+// Return: 0
+static int simulationWorker(void * data){
+    SimulationThread * st = (SimulationThread*)data;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 batchTime = frequency * BATCH_TIME_LIMIT / 1000;
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 now, next, batchEnd;
+    long long paced = 0;
+    int speed = st->sim->speed;
+    
+    SDL_LockMutex(st->lock);
+    while(!st->quit){
+        now = SDL_GetPerformanceCounter();
+        if(!st->sim->running){
+            SDL_CondWait(st->wake, st->lock);
+            start = SDL_GetPerformanceCounter();
+            paced = 0;
+            continue;
+        }
+        if(st->sim->speed != speed){
+            // The new speed is paced from now on
+            speed = st->sim->speed;
+            start = now;
+            paced = 0;
+        }
+        if(speed != SPEED_UNLIMITED){
+            next = dueTime(start, paced, speed, frequency);
+            if(now < next){
+                // Wait for the next generation (the lock is released while waiting)
+                SDL_CondWaitTimeout(st->wake, st->lock, (Uint32)(((next - now) * 1000 + frequency - 1) / frequency));
+                continue;
+            }
+        }
+        // Calculate the due generations until the batch takes too long or the user needs the simulation
+        batchEnd = now + batchTime;
+        while(stepGeneration(st)){
+            paced++;
+            now = SDL_GetPerformanceCounter();
+            if(now >= batchEnd || SDL_AtomicGet(&st->waiting) > 0 ||
+               (speed != SPEED_UNLIMITED && dueTime(start, paced, speed, frequency) > now)){
+                break;
+            }
+        }
+        publishGeneration(st);
+        if(speed != SPEED_UNLIMITED && dueTime(start, paced, speed, frequency) < now){
+            // The generations are slower than the speed: the pace restarts instead of catching up in a burst
+            start = now;
+            paced = 0;
+        }
+        while(SDL_AtomicGet(&st->waiting) > 0 && !st->quit){
+            // Let the waiting thread access the simulation before the next batch
+            SDL_CondWaitTimeout(st->wake, st->lock, 1);
+        }
+    }
+    SDL_UnlockMutex(st->lock);
+    return 0;
+}
+
+// Start the worker thread of the simulation
+// Return: Pointer to the simulation thread
+SimulationThread * simulationthread_init(Simulation * sim){
+    SimulationThread * st = malloc(sizeof(SimulationThread));
+    if(st == NULL){
+        notEnoughMemory();
+    }
+    st->sim = sim;
+    st->front = 0;
+    st->backReady = false;
+    st->stale = true;
+    st->quit = false;
+    st->level = 0;
+    st->view = (SDL_Rect){0, 0, 0, 0};
+    SDL_AtomicSet(&st->waiting, 0);
+    for(int i = 0; i < 2; i++){
+        st->snapshots[i].map = bitmap_init(0, 0);
+        st->snapshots[i].universe = sim->universe != NULL ? universe_init() : NULL;
+        st->snapshots[i].pyramid = pyramid_init(0, 0);
+    }
+    takeSnapshot(&st->snapshots[st->front], sim, st->level, st->view);
+    st->lock = SDL_CreateMutex();
+    st->swapLock = SDL_CreateMutex();
+    st->wake = SDL_CreateCond();
+    if(st->lock == NULL || st->swapLock == NULL || st->wake == NULL){
+        notEnoughMemory();
+    }
+    st->thread = SDL_CreateThread(simulationWorker, "simulation", st);
+    if(st->thread == NULL){
+        printf("SDL_CreateThread: %s\n", SDL_GetError());
+        notEnoughMemory();
+    }
+    return st;
+}
+
+// Stop the worker thread and free the snapshots
+void simulationthread_destroy(SimulationThread * st){
+    if(st == NULL){
+        return;
+    }
+    SDL_LockMutex(st->lock);
+    st->quit = true;
+    SDL_CondSignal(st->wake);
+    SDL_UnlockMutex(st->lock);
+    SDL_WaitThread(st->thread, NULL);
+    SDL_DestroyCond(st->wake);
+    SDL_DestroyMutex(st->swapLock);
+    SDL_DestroyMutex(st->lock);
+    for(int i = 0; i < 2; i++){
+        bitmap_free(&st->snapshots[i].map);
+        universe_free(st->snapshots[i].universe);
+        pyramid_free(&st->snapshots[i].pyramid);
+    }
+    free(st);
+}
+
+// Get exclusive access to the simulation
+// (it waits until the worker finishes the generation it is calculating)
+void lockSimulation(SimulationThread * st){
+    SDL_AtomicAdd(&st->waiting, 1);
+    SDL_LockMutex(st->lock);
+    SDL_AtomicAdd(&st->waiting, -1);
+}
+
+// Release the simulation after it was accessed with lockSimulation()
+// (the worker is woken up to apply the changes, and the next frame shows the current state)
+void unlockSimulation(SimulationThread * st){
+    st->stale = true;
+    SDL_CondSignal(st->wake);
+    SDL_UnlockMutex(st->lock);
+}
+
+// Get the snapshot the next frame should show
+// (called by the renderer before it draws a frame)
+// level, view: the frame samples the given blocks of 2^level x 2^level cells, the snapshots copy only them
+// Return: Pointer to the front snapshot
+const Snapshot * latestSnapshot(SimulationThread * st, int level, SDL_Rect view){
+    // The plane is copied whole, the view only matters on a map
+    // (the event loop is the only thread that replaces the universe, so it can be read without the lock)
+    if(st->sim->universe == NULL && (level != st->level || !SDL_RectEquals(&view, &st->view))){
+        // The view moved: the snapshots don't contain the new part of the map
+        lockSimulation(st);
+        st->level = level;
+        st->view = view;
+        SDL_UnlockMutex(st->lock);
+        st->stale = true;
+    }
+    if(st->stale){
+        // The user modified the simulation: the front snapshot is taken from the current state,
+        // and the back snapshot (an older generation) is dropped
+        lockSimulation(st);
+        takeSnapshot(&st->snapshots[st->front], st->sim, st->level, st->view);
+        st->stale = false;
+        SDL_LockMutex(st->swapLock);
+        st->backReady = false;
+        SDL_UnlockMutex(st->swapLock);
+        SDL_UnlockMutex(st->lock);
+        return &st->snapshots[st->front];
+    }
+    SDL_LockMutex(st->swapLock);
+    if(st->backReady){
+        st->front = 1 - st->front;
+        st->backReady = false;
+    }
+    SDL_UnlockMutex(st->swapLock);
+    return &st->snapshots[st->front];
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "simulation.h"
+
+// Longest time the worker calculates generations in a batch before it publishes the last one (in milliseconds)
+#define BATCH_TIME_LIMIT 16
+
+// Copy of the state of the simulation that is drawn on the screen
+typedef struct Snapshot{
+    Bitmap map;           // Copy of the map (only the region is up to date)
+    SDL_Rect region;      // Words (x, w) and rows (y, h) of the map copied for the view
+    Universe * universe;  // Copy of the unbounded plane (NULL if the simulation uses a map)
+    Pyramid pyramid;      // Copy of the population pyramid of the map (only the blocks of the view on its level are up to date)
+    bool hasPyramid;      // The pyramid was copied (only when the view samples a stored level)
+    Stats stats;          // Performance counters of the simulation at the time of the copy
+    CellStats cells;      // Statistics of the cells gathered by the last step
+    size_t memory;        // Memory used by the simulation (in bytes)
+} Snapshot;
+
+// Thread that advances the running simulation at the selected speed
+// The renderer draws a snapshot of the latest finished generation, so stepping
+// never waits for the screen. The worker fills the back snapshot, the renderer swaps
+// it with the front one when it starts a new frame.
+// Above the frame rate the generations that are due are calculated in batches and
+// only the last generation of a batch is published.
+typedef struct SimulationThread{
+    Simulation * sim;       // Simulation advanced by the thread
+    SDL_Thread * thread;    // Worker thread
+    SDL_mutex * lock;       // Protects the simulation (held by the worker while it calculates a batch of generations)
+    SDL_atomic_t waiting;   // Number of threads waiting for the lock (the worker ends its batch early)
+    SDL_cond * wake;        // Signalled when the simulation was modified or the thread should exit
+    SDL_mutex * swapLock;   // Protects backReady
+    Snapshot snapshots[2];  // Front (drawn by the renderer) and back (filled by the worker) snapshots
+    int front;              // Index of the front snapshot
+    bool backReady;         // The back snapshot holds a generation that was not drawn yet
+    bool stale;             // The simulation was modified by the user, the front snapshot is outdated
+    int level;              // The renderer samples blocks of 2^level x 2^level cells (population densities above level 0)
+    SDL_Rect view;          // Blocks sampled by the renderer, the snapshots copy only this part of the map
+    bool quit;              // The worker should exit
+} SimulationThread;
+
+// Start the worker thread of the simulation
+// Return: Pointer to the simulation thread
+SimulationThread * simulationthread_init(Simulation * sim);
+
+// Stop the worker thread and free the snapshots
+void simulationthread_destroy(SimulationThread * st);
+
+// Get exclusive access to the simulation
+// (it waits until the worker finishes the generation it is calculating)
+void lockSimulation(SimulationThread * st);
+
+// Release the simulation after it was accessed with lockSimulation()
+// (the worker is woken up to apply the changes, and the next frame shows the current state)
+void unlockSimulation(SimulationThread * st);
+
+// Get the snapshot the next frame should show
+// (called by the renderer before it draws a frame)
+// level, view: the frame samples the given blocks of 2^level x 2^level cells, the snapshots copy only them
+// Return: Pointer to the front snapshot
+const Snapshot * latestSnapshot(SimulationThread * st, int level, SDL_Rect view);
+
+#endif
\ No newline at end of file
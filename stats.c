@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+
+// Initialize the counters
+// Return: Stats with every counter zero
+Stats stats_init(){
+    Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+}
+
+// Add the time elapsed since start to a stage
+// start: value of SDL_GetPerformanceCounter() when the stage started
+// Return: Duration of the run (in seconds)
+double stopTimer(StageTime * stage, Uint64 start){
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    stage->last = seconds;
+    stage->total += seconds;
+    stage->runs++;
+    return seconds;
+}
+
+// Average duration of the runs of a stage since an earlier copy of it
+// Return: Duration in milliseconds (0 if there were no runs)
+double averageTime(const StageTime * stage, const StageTime * since){
+    long long runs = stage->runs - since->runs;
+    if(runs <= 0){
+        return 0;
+    }
+    return (stage->total - since->total) * 1000 / runs;
+}
+
+// Record the duration of a frame
+void recordFrameTime(FrameStats * frames, double seconds){
+    frames->times[frames->next] = (float)(seconds * 1000);
+    frames->next = (frames->next + 1) % FRAME_SAMPLES;
+    if(frames->numOfFrames < FRAME_SAMPLES){
+        frames->numOfFrames++;
+    }
+}
+
+// Order of two frame durations for qsort()
+// Return: Negative, zero or positive
+static int compareTimes(const void * a, const void * b){
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Get a percentile of the duration of the last frames
+// percent: 0 - 100
+// Return: Duration in milliseconds (0 if no frame was recorded)
+double frameTimePercentile(const FrameStats * frames, double percent){
+    float sorted[FRAME_SAMPLES];
+    int index;
+    if(frames->numOfFrames == 0){
+        return 0;
+    }
+    memcpy(sorted, frames->times, frames->numOfFrames * sizeof(float));
+    qsort(sorted, frames->numOfFrames, sizeof(float), compareTimes);
+    // Nearest rank
+    index = (int)(percent / 100 * frames->numOfFrames + 0.999999) - 1;
+    if(index < 0){
+        index = 0;
+    } else if(index >= frames->numOfFrames){
+        index = frames->numOfFrames - 1;
+    }
+    return sorted[index];
+}
\ No newline at end of file
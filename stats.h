@@ -0,0 +1,64 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Number of frames the frame time percentiles are calculated from
+#define FRAME_SAMPLES 256
+
+// Time spent in a stage of the program
+typedef struct StageTime{
+    double last;    // Duration of the last run (in seconds)
+    double total;   // Duration of all the runs (in seconds)
+    long long runs; // Number of runs
+} StageTime;
+
+// Statistics of the cells gathered by the step while it calculates a generation
+// (the step adds up the partial sums of the bands or the jobs of the threads)
+typedef struct CellStats{
+    long long population;  // Number of active cells
+    long long births;      // Cells that became active in the last generation
+    long long deaths;      // Cells that became inactive in the last generation
+    int calculatedTiles;   // Tiles calculated in the last generation
+    int changedTiles;      // Tiles that changed in the last generation
+} CellStats;
+
+// Performance counters of the simulation (updated by whoever holds the simulation)
+typedef struct Stats{
+    StageTime step;        // Calculation of the generations (cycle() and fast-forward)
+    StageTime io;          // Saving and loading maps
+    long long generations; // Number of generations calculated
+} Stats;
+
+// Timing of the frames drawn by the renderer
+typedef struct FrameStats{
+    StageTime render;              // Drawing a frame to the back buffer (without presenting it)
+    StageTime present;             // Presenting the frame (it includes waiting for the display refresh)
+    float times[FRAME_SAMPLES];    // Duration of the last frames (render and present, in milliseconds)
+    int numOfFrames;               // Number of the recorded durations
+    int next;                      // Position of the next duration
+} FrameStats;
+
+// Initialize the counters
+// Return: Stats with every counter zero
+Stats stats_init();
+
+// Add the time elapsed since start to a stage
+// start: value of SDL_GetPerformanceCounter() when the stage started
+// Return: Duration of the run (in seconds)
+double stopTimer(StageTime * stage, Uint64 start);
+
+// Average duration of the runs of a stage since an earlier copy of it
+// Return: Duration in milliseconds (0 if there were no runs)
+double averageTime(const StageTime * stage, const StageTime * since);
+
+// Record the duration of a frame
+void recordFrameTime(FrameStats * frames, double seconds);
+
+// Get a percentile of the duration of the last frames
+// percent: 0 - 100
+// Return: Duration in milliseconds (0 if no frame was recorded)
+double frameTimePercentile(const FrameStats * frames, double percent);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../error.h"
+#include "../simulation.h"
+
+// Number of generations every case is stepped
+#define GENERATIONS 40
+
+// A HashLife jump of 2^JUMP_EXPONENT generations is compared with stepping
+#define JUMP_EXPONENT 5
+
+// Memory limit of the HashLife node cache of a jump (in bytes)
+#define JUMP_MEMORY (64 * 1024 * 1024)
+
+// Thread counts the kernels are run with (the reference is always single threaded)
+static const int threadCounts[] = {1, 3};
+
+// Dimensions of the maps (widths that are not whole words, and maps thinner than a tile)
+static const Size sizes[] = {{64, 64}, {100, 37}, {200, 129}, {1000, 3}, {1, 70}};
+
+// Rules of the cases (the rules with specialized kernels and ones calculated by the generic kernel)
+static const char * rules[] = {"B3/S23", "B36/S23", "B3678/S34678", "B2/S", "B35678/S5678", "B1/S012345678"};
+
+// Boundary modes of the cases
+static const boundary_mode boundaries[] = {boundary_dead, boundary_torus, boundary_mirror};
+
+// After a failed attempt to allocate memory,
+// print error message and exit the program
+void notEnoughMemory(){
+    printf("Memory allocation failed!\n");
+    exit(1);
+}
+
+// Name of the boundary mode (used in the output)
+// Return: Name of the mode
+static const char * boundaryName(boundary_mode boundary){
+    switch(boundary){
+        case boundary_dead:
+            return "dead";
+        case boundary_torus:
+            return "torus";
+        case boundary_mirror:
+            return "mirror";
+        default:
+            return "unknown";
+    }
+}
+
+// Fixed seed random number generator (xorshift64), so every run calculates the same boards
+// Return: Next random number
+static uint64_t nextRandom(uint64_t * state){
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Create a map with a random soup of about 3/8 active cells
+// Return: Simulation
+static Simulation randomSimulation(Size size, Rule rule, boundary_mode boundary, uint64_t seed){
+    Simulation sim = simulation_init(size.width, size.height);
+    uint64_t * row;
+    
+    sim.rule = rule;
+    sim.boundary = boundary;
+    for(int y = 0; y < sim.map.height; y++){
+        row = mapRow(&sim.map, y);
+        for(int w = 0; w < sim.map.words; w++){
+            row[w] = nextRandom(&seed) & (nextRandom(&seed) | nextRandom(&seed));
+        }
+        row[sim.map.words - 1] &= lastWordMask(&sim.map);
+    }
+    markAllTilesChanged(&sim);
+    return sim;
+}
+
+// Find the first cell where two maps of the same size differ
+// Return: TRUE if the maps are the same, FALSE otherwise (x and y are set to the cell)
+static bool compareMaps(const Bitmap * a, const Bitmap * b, int * x, int * y){
+    uint64_t mask, diff;
+    for(int r = 0; r < a->height; r++){
+        for(int w = 0; w < a->words; w++){
+            mask = w == a->words - 1 ? lastWordMask(a) : ~(uint64_t)0;
+            diff = (mapRow(a, r)[w] ^ mapRow(b, r)[w]) & mask;
+            if(diff != 0){
+                *x = w * WORD_BITS + __builtin_ctzll(diff);
+                *y = r;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Copy the cells of a map to an unbounded plane (the top left cell of the map is the origin)
+// Return: Simulation
+static Simulation planeOfMap(const Simulation * sim){
+    Simulation plane = simulation_initUnbounded();
+    uint64_t word;
+    plane.rule = sim->rule;
+    for(int y = 0; y < sim->map.height; y++){
+        for(int w = 0; w < sim->map.words; w++){
+            for(word = mapRow(&sim->map, y)[w]; word != 0; word &= word - 1){
+                editCell(&plane, w * WORD_BITS + __builtin_ctzll(word), y, 1);
+            }
+        }
+    }
+    return plane;
+}
+
+// Find the first cell where two planes differ
+// Return: TRUE if the planes are the same, FALSE otherwise (x and y are set to the cell)
+static bool comparePlanes(Simulation * a, Simulation * b, int * x, int * y){
+    int left, top, width, height;
+    int otherLeft, otherTop, otherWidth, otherHeight;
+    bool active = populationBounds(a, &left, &top, &width, &height);
+    bool otherActive = populationBounds(b, &otherLeft, &otherTop, &otherWidth, &otherHeight);
+    *x = *y = 0;
+    if(active != otherActive || left != otherLeft || top != otherTop || width != otherWidth || height != otherHeight){
+        return false;
+    }
+    for(*y = top; *y < top + height; (*y)++){
+        for(*x = left; *x < left + width; (*x)++){
+            if(getSimulationCell(a, *x, *y) != getSimulationCell(b, *x, *y)){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Fast-forward a random map with HashLife and step a copy of it generation by generation,
+// in every boundary mode and on the unbounded plane
+// (a simulation that refuses the jump must keep its cells)
+// Return: Number of failed cases
+static int checkFastForward(Rule rule, uint64_t seed, int * numOfCases){
+    Size size = {100, 90};
+    int numOfModes = (int)(sizeof(boundaries) / sizeof(boundaries[0]));
+    int failures = 0;
+    int x, y;
+    bool plane, jumped, same;
+    Simulation map, jump, step;
+    
+    for(int b = 0; b <= numOfModes; b++){
+        plane = b == numOfModes;
+        map = randomSimulation(size, rule, plane ? boundary_dead : boundaries[b], seed);
+        jump = plane ? planeOfMap(&map) : randomSimulation(size, rule, boundaries[b], seed);
+        step = plane ? planeOfMap(&map) : randomSimulation(size, rule, boundaries[b], seed);
+        jump.hashlife = hashlife_init(JUMP_MEMORY);
+        jump.fastForwardExponent = JUMP_EXPONENT;
+        jumped = fastForward(&jump);
+        for(int g = 0; jumped && g < 1 << JUMP_EXPONENT; g++){
+            cycle(&step);
+        }
+        same = plane ? comparePlanes(&jump, &step, &x, &y) : compareMaps(&jump.map, &step.map, &x, &y);
+        (*numOfCases)++;
+        if(!same){
+            failures++;
+            printf("FAIL fast-forward%s, %s boundary: cell %d,%d differs from stepping\n",
+                   jumped ? "" : " (refused)", plane ? "unbounded" : boundaryName(boundaries[b]), x, y);
+        }
+        simulation_free(&map);
+        simulation_free(&jump);
+        simulation_free(&step);
+    }
+    return failures;
+}
+
+// Step random maps with every supported kernel and compare them with the scalar kernel,
+// and compare HashLife jumps with stepping
+// Return: 0 if every case calculated the same cells, 1 otherwise
+int main(){
+    int numOfCases = 0, failures = 0;
+    int x, y;
+    Rule rule;
+    Simulation reference, sim;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    
+    for(int r = 0; r < (int)(sizeof(rules) / sizeof(rules[0])); r++){
+        if(!parseRule(rules[r], &rule)){
+            printf("Invalid rule: %s\n", rules[r]);
+            return 1;
+        }
+        for(int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++){
+            for(int b = 0; b < (int)(sizeof(boundaries) / sizeof(boundaries[0])); b++){
+                seed = nextRandom(&seed);
+                reference = randomSimulation(sizes[s], rule, boundaries[b], seed);
+                reference.kernel = kernel_scalar;
+                for(int g = 0; g < GENERATIONS; g++){
+                    cycle(&reference);
+                }
+                for(step_kernel k = kernel_scalar; k <= kernel_avx512; k++){
+                    if(!kernelSupported(k)){
+                        continue;
+                    }
+                    for(int t = 0; t < (int)(sizeof(threadCounts) / sizeof(threadCounts[0])); t++){
+                        sim = randomSimulation(sizes[s], rule, boundaries[b], seed);
+                        sim.kernel = k;
+                        setThreadCount(&sim, threadCounts[t]);
+                        for(int g = 0; g < GENERATIONS; g++){
+                            cycle(&sim);
+                        }
+                        numOfCases++;
+                        if(!compareMaps(&reference.map, &sim.map, &x, &y)){
+                            failures++;
+                            printf("FAIL %s, %s, %dx%d, %s boundary, %d thread(s): cell %d,%d differs\n",
+                                   kernelName(k), rules[r], sizes[s].width, sizes[s].height,
+                                   boundaryName(boundaries[b]), threadCounts[t], x, y);
+                        }
+                        simulation_free(&sim);
+                    }
+                }
+                simulation_free(&reference);
+            }
+        }
+        seed = nextRandom(&seed);
+        failures += checkFastForward(rule, seed, &numOfCases);
+    }
+    printf("%d case(s), %d failed\n", numOfCases, failures);
+    return failures > 0 ? 1 : 0;
+}
\ No newline at end of file
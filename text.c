@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "text.h"
+
+// Font files tried when no font is given
+static const char * defaultFonts[] = {
+#ifdef _WIN32
+    "C:\\Windows\\Fonts\\arial.ttf",
+#else
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/TTF/DejaVuSans.ttf",
+    "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+    "/usr/share/fonts/liberation/LiberationSans-Regular.ttf",
+    "/System/Library/Fonts/Supplemental/Arial.ttf",
+#endif
+};
+
+// Font of every text
+static TTF_Font * font = NULL;
+
+// Textures of the recently drawn texts
+static CachedText cache[TEXT_CACHE_SIZE];
+
+// Incremented on every lookup of the cache
+static unsigned long cacheClock = 0;
+
+// Open the font of the texts
+// fontPath: TrueType font file, NULL: the default font of the system
+// Return: TRUE if the font was opened, FALSE otherwise (the texts are not drawn)
+bool text_init(const char * fontPath){
+    if(fontPath != NULL){
+        font = TTF_OpenFont(fontPath, FONT_SIZE);
+    } else {
+        for(size_t i = 0; font == NULL && i < sizeof(defaultFonts) / sizeof(defaultFonts[0]); i++){
+            fontPath = defaultFonts[i];
+            font = TTF_OpenFont(fontPath, FONT_SIZE);
+        }
+    }
+    if(font == NULL){
+        printf("TTF_OpenFont: %s\n", TTF_GetError());
+        printf("Use --font=PATH to select a TrueType font\n");
+        return false;
+    }
+    return true;
+}
+
+// Frees the cached textures and closes the font
+void text_free(){
+    for(int i = 0; i < TEXT_CACHE_SIZE; i++){
+        if(cache[i].texture != NULL){
+            SDL_DestroyTexture(cache[i].texture);
+        }
+    }
+    memset(cache, 0, sizeof(cache));
+    if(font != NULL){
+        TTF_CloseFont(font);
+        font = NULL;
+    }
+}
+
+// Render a text to a new texture (the caller destroys it)
+// Return: Generated texture, or NULL if the text can not be rendered
+SDL_Texture * renderText(SDL_Renderer * renderer, const char * text, const SDL_Color * fg, const SDL_Color * bg){
+    if(font == NULL || text[0] == '\0'){
+        return NULL;
+    }
+    SDL_Surface * textSurface = TTF_RenderUTF8_Shaded(font, text, *fg, *bg);
+    if(textSurface == NULL){
+        printf("TTF_RenderUTF8_Shaded: %s\n", TTF_GetError());
+        return NULL;
+    }
+    SDL_Texture * texture = SDL_CreateTextureFromSurface(renderer, textSurface);
+    SDL_FreeSurface(textSurface);
+    return texture;
+}
+
+// Compare two colors
+// Return: TRUE if the colors are the same, FALSE otherwise
+static bool sameColor(const SDL_Color * a, const SDL_Color * b){
+    return a->r == b->r && a->g == b->g && a->b == b->b && a->a == b->a;
+}
+
+// Get the texture of a text from the cache, rendering it on the first use
+// The texture is owned by the cache and stays valid until TEXT_CACHE_SIZE other texts are used
+// Return: Texture (NULL if the text can not be rendered), its size in width and height
+SDL_Texture * cachedText(SDL_Renderer * renderer, const char * text, const SDL_Color * fg, const SDL_Color * bg, int * width, int * height){
+    CachedText * entry;
+    CachedText * oldest = &cache[0];
+    *width = 0;
+    *height = 0;
+    if(strlen(text) >= MAX_CACHED_TEXT){
+        return NULL;
+    }
+    cacheClock++;
+    for(int i = 0; i < TEXT_CACHE_SIZE; i++){
+        entry = &cache[i];
+        if(entry->texture != NULL && strcmp(entry->text, text) == 0 &&
+           sameColor(&entry->fg, fg) && sameColor(&entry->bg, bg)){
+            entry->lastUse = cacheClock;
+            *width = entry->width;
+            *height = entry->height;
+            return entry->texture;
+        }
+        if(entry->lastUse < oldest->lastUse){
+            oldest = entry;
+        }
+    }
+    // Not in the cache: the least recently used (or an unused) entry is replaced
+    SDL_Texture * texture = renderText(renderer, text, fg, bg);
+    if(texture == NULL){
+        return NULL;
+    }
+    if(oldest->texture != NULL){
+        SDL_DestroyTexture(oldest->texture);
+    }
+    strcpy(oldest->text, text);
+    oldest->fg = *fg;
+    oldest->bg = *bg;
+    oldest->texture = texture;
+    oldest->lastUse = cacheClock;
+    SDL_QueryTexture(texture, NULL, NULL, &oldest->width, &oldest->height);
+    *width = oldest->width;
+    *height = oldest->height;
+    return texture;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+// Size of the font of the texts
+#define FONT_SIZE 12
+
+// Number of text textures kept in the cache
+#define TEXT_CACHE_SIZE 64
+
+// Longest text that is cached (including the terminating zero)
+#define MAX_CACHED_TEXT 32
+
+// Texture of a text in the cache
+typedef struct CachedText{
+    char text[MAX_CACHED_TEXT]; // The text (empty: unused entry)
+    SDL_Color fg;               // Color of the letters
+    SDL_Color bg;               // Color of the background
+    SDL_Texture * texture;      // Rendered text
+    int width;                  // Size of the texture
+    int height;
+    unsigned long lastUse;      // Time of the last use (the least recently used entry is replaced)
+} CachedText;
+
+// Open the font of the texts
+// fontPath: TrueType font file, NULL: the default font of the system
+// Return: TRUE if the font was opened, FALSE otherwise (the texts are not drawn)
+bool text_init(const char * fontPath);
+
+// Frees the cached textures and closes the font
+void text_free();
+
+// Render a text to a new texture (the caller destroys it)
+// Return: Generated texture, or NULL if the text can not be rendered
+SDL_Texture * renderText(SDL_Renderer * renderer, const char * text, const SDL_Color * fg, const SDL_Color * bg);
+
+// Get the texture of a text from the cache, rendering it on the first use
+// The texture is owned by the cache and stays valid until TEXT_CACHE_SIZE other texts are used
+// Return: Texture (NULL if the text can not be rendered), its size in width and height
+SDL_Texture * cachedText(SDL_Renderer * renderer, const char * text, const SDL_Color * fg, const SDL_Color * bg, int * width, int * height);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "error.h"
+#include "threadPool.h"
+
+// Take jobs of the current task until there are no more left
+// (called with the lock held, the lock is released while a job is executed)
+static void takeJobs(ThreadPool * pool){
+    int job;
+    while(pool->nextJob < pool->numOfJobs){
+        job = pool->nextJob++;
+        SDL_UnlockMutex(pool->lock);
+        pool->task(pool->context, job);
+        SDL_LockMutex(pool->lock);
+        pool->finishedJobs++;
+        if(pool->finishedJobs == pool->numOfJobs){
+            SDL_CondBroadcast(pool->done);
+        }
+    }
+}
+
+// Main loop of a worker thread
+// Return: 0
+static int poolWorker(void * data){
+    ThreadPool * pool = (ThreadPool*)data;
+    unsigned seenTask = 0;
+    SDL_LockMutex(pool->lock);
+    while(true){
+        while(!pool->quit && pool->taskCounter == seenTask){
+            SDL_CondWait(pool->start, pool->lock);
+        }
+        if(pool->quit){
+            break;
+        }
+        seenTask = pool->taskCounter;
+        takeJobs(pool);
+    }
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+// Start the worker threads
+// Return: Pointer to the thread pool
+ThreadPool * threadpool_init(int numOfThreads){
+    ThreadPool * pool = calloc(1, sizeof(ThreadPool));
+    if(pool == NULL){
+        notEnoughMemory();
+    }
+    if(numOfThreads < 1){
+        numOfThreads = 1;
+    }
+    pool->numOfThreads = numOfThreads;
+    pool->lock = SDL_CreateMutex();
+    pool->start = SDL_CreateCond();
+    pool->done = SDL_CreateCond();
+    pool->workers = calloc(numOfThreads, sizeof(SDL_Thread *));
+    if(pool->workers == NULL){
+        notEnoughMemory();
+    }
+    for(int i = 0; i < numOfThreads - 1; i++){
+        pool->workers[i] = SDL_CreateThread(poolWorker, "simulation", pool);
+        if(pool->workers[i] == NULL){
+            // Continue with the threads that could be started
+            printf("SDL_CreateThread: %s\n", SDL_GetError());
+            pool->numOfThreads = i + 1;
+            break;
+        }
+    }
+    return pool;
+}
+
+// Stop the worker threads and free the thread pool
+void threadpool_destroy(ThreadPool * pool){
+    if(pool == NULL){
+        return;
+    }
+    SDL_LockMutex(pool->lock);
+    pool->quit = true;
+    SDL_CondBroadcast(pool->start);
+    SDL_UnlockMutex(pool->lock);
+    for(int i = 0; i < pool->numOfThreads - 1; i++){
+        SDL_WaitThread(pool->workers[i], NULL);
+    }
+    SDL_DestroyCond(pool->done);
+    SDL_DestroyCond(pool->start);
+    SDL_DestroyMutex(pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+// Execute the jobs of the task on all the threads, and wait until every job is finished
+void runParallel(ThreadPool * pool, pool_task task, void * context, int numOfJobs){
+    SDL_LockMutex(pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->numOfJobs = numOfJobs;
+    pool->nextJob = 0;
+    pool->finishedJobs = 0;
+    pool->taskCounter++;
+    SDL_CondBroadcast(pool->start);
+    takeJobs(pool);
+    while(pool->finishedJobs < pool->numOfJobs){
+        SDL_CondWait(pool->done, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+}
\ No newline at end of file
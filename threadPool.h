@@ -0,0 +1,37 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// A job of a parallel task (index: index of the job)
+typedef void (*pool_task)(void * context, int index);
+
+// Worker threads that execute the jobs of a task in parallel
+// The thread that starts the task works on the jobs as well
+typedef struct ThreadPool{
+    int numOfThreads;       // Number of threads including the calling thread
+    SDL_Thread ** workers;  // Worker threads (numOfThreads - 1)
+    SDL_mutex * lock;       // Protects the fields below
+    SDL_cond * start;       // Signalled when a new task is started or the pool is destroyed
+    SDL_cond * done;        // Signalled when all the jobs of the task are finished
+    pool_task task;         // Current task
+    void * context;         // Parameter of the current task
+    int numOfJobs;          // Number of jobs in the current task
+    int nextJob;            // Index of the next job to be taken
+    int finishedJobs;       // Number of finished jobs
+    unsigned taskCounter;   // Incremented on each new task (workers compare it to detect new tasks)
+    bool quit;              // The workers should exit
+} ThreadPool;
+
+// Start the worker threads
+// Return: Pointer to the thread pool
+ThreadPool * threadpool_init(int numOfThreads);
+
+// Stop the worker threads and free the thread pool
+void threadpool_destroy(ThreadPool * pool);
+
+// Execute the jobs of the task on all the threads, and wait until every job is finished
+void runParallel(ThreadPool * pool, pool_task task, void * context, int numOfJobs);
+
+#endif
\ No newline at end of file
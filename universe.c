@@ -0,0 +1,472 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "error.h"
+#include "kernel.h"
+#include "universe.h"
+
+// Initial size of the hash table
+#define INITIAL_BUCKETS 1024
+
+// Number of tiles calculated in a job of the thread pool
+#define TILES_PER_JOB 64
+
+// Parameters of a step of the universe
+typedef struct UniverseStep{
+    Universe * u;       // Universe
+    word_kernel kernel; // Bitwise kernel of the rule
+    Rule rule;          // Rule of the simulation
+    stats_kernel gatherStats; // Kernel that gathers the births and deaths of the tiles
+    CellStats * jobs;   // Statistics gathered by each job (added up after the step)
+} UniverseStep;
+
+// Hash of a tile position
+// Return: Hash value
+static size_t tileHash(int x, int y){
+    uint64_t h = (uint64_t)(uint32_t)x * 0x9E3779B97F4A7C15ull ^ (uint64_t)(uint32_t)y * 0xC2B2AE3D27D4EB4Full;
+    h ^= h >> 31;
+    return (size_t)h;
+}
+
+// Initialize an empty universe
+// Return: Pointer to the universe
+Universe * universe_init(){
+    Universe * u = calloc(1, sizeof(Universe));
+    if(u == NULL){
+        notEnoughMemory();
+    }
+    u->numOfBuckets = INITIAL_BUCKETS;
+    u->buckets = calloc(u->numOfBuckets, sizeof(Tile *));
+    if(u->buckets == NULL){
+        notEnoughMemory();
+    }
+    return u;
+}
+
+// Frees the memory allocated by the universe
+void universe_free(Universe * u){
+    if(u == NULL){
+        return;
+    }
+    clearUniverse(u);
+    free(u->tiles);
+    free(u->buckets);
+    free(u);
+}
+
+// Remove every tile
+void clearUniverse(Universe * u){
+    for(int i = 0; i < u->numOfTiles; i++){
+        free(u->tiles[i]);
+    }
+    u->numOfTiles = 0;
+    memset(u->buckets, 0, u->numOfBuckets * sizeof(Tile *));
+}
+
+// Double the size of the hash table
+static void growBuckets(Universe * u){
+    size_t numOfBuckets = u->numOfBuckets * 2;
+    Tile ** buckets = calloc(numOfBuckets, sizeof(Tile *));
+    Tile * tile;
+    size_t index;
+    if(buckets == NULL){
+        return;
+    }
+    for(int i = 0; i < u->numOfTiles; i++){
+        tile = u->tiles[i];
+        index = tileHash(tile->x, tile->y) & (numOfBuckets - 1);
+        tile->chain = buckets[index];
+        buckets[index] = tile;
+    }
+    free(u->buckets);
+    u->buckets = buckets;
+    u->numOfBuckets = numOfBuckets;
+}
+
+// Get the tile at the given position
+// Return: Pointer to the tile, or NULL if it is not allocated
+Tile * findTile(const Universe * u, int x, int y){
+    Tile * tile = u->buckets[tileHash(x, y) & (u->numOfBuckets - 1)];
+    while(tile != NULL && (tile->x != x || tile->y != y)){
+        tile = tile->chain;
+    }
+    return tile;
+}
+
+// Get the tile at the given position, allocate an empty one if it does not exist
+// Return: Pointer to the tile
+static Tile * addTile(Universe * u, int x, int y){
+    Tile * tile = findTile(u, x, y);
+    size_t index;
+    if(tile != NULL){
+        return tile;
+    }
+    tile = calloc(1, sizeof(Tile));
+    if(tile == NULL){
+        notEnoughMemory();
+    }
+    if(u->numOfTiles == u->capacity){
+        u->capacity = u->capacity == 0 ? 64 : u->capacity * 2;
+        u->tiles = realloc(u->tiles, u->capacity * sizeof(Tile *));
+        if(u->tiles == NULL){
+            notEnoughMemory();
+        }
+    }
+    tile->x = x;
+    tile->y = y;
+    tile->index = u->numOfTiles;
+    u->tiles[u->numOfTiles++] = tile;
+    index = tileHash(x, y) & (u->numOfBuckets - 1);
+    tile->chain = u->buckets[index];
+    u->buckets[index] = tile;
+    if((size_t)u->numOfTiles > u->numOfBuckets){
+        growBuckets(u);
+    }
+    return tile;
+}
+
+// Remove the tile from the universe and free it
+static void removeTile(Universe * u, Tile * tile){
+    Tile ** link = &u->buckets[tileHash(tile->x, tile->y) & (u->numOfBuckets - 1)];
+    while(*link != tile){
+        link = &(*link)->chain;
+    }
+    *link = tile->chain;
+    u->numOfTiles--;
+    u->tiles[tile->index] = u->tiles[u->numOfTiles];
+    u->tiles[tile->index]->index = tile->index;
+    free(tile);
+}
+
+// Copy the content of the universe to another
+void copyUniverse(Universe * dst, const Universe * src){
+    Tile * tile;
+    clearUniverse(dst);
+    for(int i = 0; i < src->numOfTiles; i++){
+        tile = addTile(dst, src->tiles[i]->x, src->tiles[i]->y);
+        memcpy(tile->cells, src->tiles[i]->cells, sizeof(tile->cells));
+        tile->stats = src->tiles[i]->stats;
+    }
+}
+
+// Get the state of the cell
+// Return: 1 if the cell is active, 0 otherwise
+int getUniverseCell(const Universe * u, int x, int y){
+    Tile * tile = findTile(u, x >> 6, y >> 6);
+    if(tile == NULL){
+        return 0;
+    }
+    return (int)((tile->cells[y & 63] >> (x & 63)) & 0x1);
+}
+
+// Set the state of the cell
+// (the population and the used columns and rows of the tile are updated)
+void setUniverseCell(Universe * u, int x, int y, int state){
+    Tile * tile;
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    if(state){
+        tile = addTile(u, x >> 6, y >> 6);
+        if((tile->cells[y & 63] & bit) == 0){
+            tile->cells[y & 63] |= bit;
+            tile->stats.population++;
+            tile->stats.columns |= bit;
+            tile->stats.rows |= (uint64_t)1 << (y & 63);
+        }
+    } else {
+        // Empty tiles are freed by the next step
+        tile = findTile(u, x >> 6, y >> 6);
+        if(tile != NULL && (tile->cells[y & 63] & bit) != 0){
+            tile->cells[y & 63] &= ~bit;
+            tile->stats.population--;
+            tile->stats.columns = 0;
+            tile->stats.rows = 0;
+            for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+                tile->stats.columns |= tile->cells[r];
+                tile->stats.rows |= (uint64_t)(tile->cells[r] != 0) << r;
+            }
+        }
+    }
+}
+
+// Allocate the neighbours of the tile that can get active cells in the next step
+static void expandTile(Universe * u, int index){
+    Tile * tile = u->tiles[index];
+    int x = tile->x, y = tile->y;
+    uint64_t top = tile->cells[0];
+    uint64_t bottom = tile->cells[UNIVERSE_TILE_SIZE - 1];
+    uint64_t left = 0, right = 0;
+    for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+        left |= tile->cells[r] & 0x1;
+        right |= tile->cells[r] >> 63;
+    }
+    // addTile() can move the list, so the tile pointer is not used below
+    if(top){
+        addTile(u, x, y - 1);
+    }
+    if(bottom){
+        addTile(u, x, y + 1);
+    }
+    if(left){
+        addTile(u, x - 1, y);
+    }
+    if(right){
+        addTile(u, x + 1, y);
+    }
+    if(top & 0x1){
+        addTile(u, x - 1, y - 1);
+    }
+    if(top >> 63){
+        addTile(u, x + 1, y - 1);
+    }
+    if(bottom & 0x1){
+        addTile(u, x - 1, y + 1);
+    }
+    if(bottom >> 63){
+        addTile(u, x + 1, y + 1);
+    }
+}
+
+// Calculate the next state of a tile
+// The rows of the tile and its neighbours are collected into a 3 word wide band,
+// and the band is calculated with the bitwise kernel of the rule
+// job: the births, the deaths and the changed tiles are added to it
+static void stepTile(const UniverseStep * step, Tile * tile, CellStats * job){
+    const Universe * u = step->u;
+    uint64_t band[UNIVERSE_TILE_SIZE + 2][3];
+    uint64_t result[3];
+    const Tile * neighbour;
+    TileCounters counters;
+    memset(&counters, 0, sizeof(counters));
+
+    for(int dy = -1; dy <= 1; dy++){
+        for(int dx = -1; dx <= 1; dx++){
+            neighbour = (dx == 0 && dy == 0) ? tile : findTile(u, tile->x + dx, tile->y + dy);
+            if(dy == -1){
+                band[0][dx + 1] = neighbour ? neighbour->cells[UNIVERSE_TILE_SIZE - 1] : 0;
+            } else if(dy == 1){
+                band[UNIVERSE_TILE_SIZE + 1][dx + 1] = neighbour ? neighbour->cells[0] : 0;
+            } else {
+                for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+                    band[r + 1][dx + 1] = neighbour ? neighbour->cells[r] : 0;
+                }
+            }
+        }
+    }
+    for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+        step->kernel(band[r], band[r + 1], band[r + 2], result, 1, 2, step->rule);
+        tile->next[r] = result[1];
+        // Every row of the tile is a row of one word
+        step->gatherStats(&tile->cells[r], &tile->next[r], &counters, r, 0, 1, ~(uint64_t)0);
+    }
+    tile->stats.births = (uint16_t)counters.births[0];
+    tile->stats.deaths = (uint16_t)counters.deaths[0];
+    tile->stats.columns = counters.columns[0];
+    tile->stats.rows = counters.rows[0];
+    tile->stats.population += tile->stats.births - tile->stats.deaths;
+    job->births += tile->stats.births;
+    job->deaths += tile->stats.deaths;
+    job->changedTiles += tile->stats.births != 0 || tile->stats.deaths != 0;
+}
+
+// Calculate the next state of a group of tiles (a job of the thread pool)
+static void stepTiles(void * context, int job){
+    UniverseStep * step = (UniverseStep*)context;
+    Universe * u = step->u;
+    int first = job * TILES_PER_JOB;
+    int last = first + TILES_PER_JOB;
+    if(last > u->numOfTiles){
+        last = u->numOfTiles;
+    }
+    step->jobs[job] = (CellStats){0};
+    for(int i = first; i < last; i++){
+        stepTile(step, u->tiles[i], &step->jobs[job]);
+    }
+}
+
+// Advance the universe to the next state with the given rule
+// (pool: threads that calculate the tiles, NULL: single threaded)
+// stats: the births, the deaths and the calculated and changed tiles of the step are added to it
+void stepUniverse(Universe * u, ThreadPool * pool, Rule rule, CellStats * stats){
+    UniverseStep step = {u, wordKernel(kernel_bitwise, rule), rule, statsKernel(), NULL};
+    int numOfTiles = u->numOfTiles;
+    int numOfJobs;
+    Tile * tile;
+
+    // Activity can only spread to the direct neighbours of the tiles
+    for(int i = 0; i < numOfTiles; i++){
+        expandTile(u, i);
+    }
+
+    numOfJobs = (u->numOfTiles + TILES_PER_JOB - 1) / TILES_PER_JOB;
+    // One extra element, so an empty universe also gets a valid array
+    CellStats jobs[numOfJobs + 1];
+    step.jobs = jobs;
+    if(pool == NULL || pool->numOfThreads == 1 || numOfJobs < 2){
+        for(int job = 0; job < numOfJobs; job++){
+            stepTiles(&step, job);
+        }
+    } else {
+        runParallel(pool, stepTiles, &step, numOfJobs);
+    }
+    // The partial sums of the jobs
+    for(int job = 0; job < numOfJobs; job++){
+        stats->births += jobs[job].births;
+        stats->deaths += jobs[job].deaths;
+        stats->changedTiles += jobs[job].changedTiles;
+    }
+    stats->calculatedTiles += u->numOfTiles;
+
+    // Apply the next state and free the empty tiles
+    for(int i = u->numOfTiles - 1; i >= 0; i--){
+        tile = u->tiles[i];
+        memcpy(tile->cells, tile->next, sizeof(tile->cells));
+        if(tile->stats.population == 0){
+            removeTile(u, tile);
+        }
+    }
+}
+
+// Get the smallest rectangle that contains every active cell
+// (it is found from the statistics of the tiles, without reading the cells)
+// Return: TRUE if there are active cells, FALSE if the universe is empty
+bool universeBounds(const Universe * u, int * x, int * y, int * width, int * height){
+    int minX = 0, minY = 0, maxX = 0, maxY = 0;
+    bool found = false;
+    int left, right, top, bottom;
+    const Tile * tile;
+
+    for(int i = 0; i < u->numOfTiles; i++){
+        tile = u->tiles[i];
+        if(tile->stats.population == 0){
+            continue;
+        }
+        left = tile->x * UNIVERSE_TILE_SIZE + __builtin_ctzll(tile->stats.columns);
+        right = tile->x * UNIVERSE_TILE_SIZE + 63 - __builtin_clzll(tile->stats.columns);
+        top = tile->y * UNIVERSE_TILE_SIZE + __builtin_ctzll(tile->stats.rows);
+        bottom = tile->y * UNIVERSE_TILE_SIZE + 63 - __builtin_clzll(tile->stats.rows);
+        if(!found){
+            minX = left;
+            maxX = right;
+            minY = top;
+            maxY = bottom;
+            found = true;
+        } else {
+            minX = left < minX ? left : minX;
+            maxX = right > maxX ? right : maxX;
+            minY = top < minY ? top : minY;
+            maxY = bottom > maxY ? bottom : maxY;
+        }
+    }
+    if(!found){
+        return false;
+    }
+    *x = minX;
+    *y = minY;
+    *width = maxX - minX + 1;
+    *height = maxY - minY + 1;
+    return true;
+}
+
+// Copy the cells of the universe inside the area of the map to the map
+// (originX, originY: position of the top left cell of the map in the universe)
+void universeToMap(const Universe * u, Bitmap * map, int originX, int originY){
+    const Tile * tile;
+    int cellX, cellY;
+    uint64_t row;
+    clearMap(map);
+    for(int i = 0; i < u->numOfTiles; i++){
+        tile = u->tiles[i];
+        for(int r = 0; r < UNIVERSE_TILE_SIZE; r++){
+            cellY = tile->y * UNIVERSE_TILE_SIZE + r - originY;
+            if(cellY < 0 || cellY >= map->height){
+                continue;
+            }
+            for(row = tile->cells[r]; row != 0; row &= row - 1){
+                cellX = tile->x * UNIVERSE_TILE_SIZE + __builtin_ctzll(row) - originX;
+                if(cellX >= 0 && cellX < map->width){
+                    setCell(map, cellX, cellY, 1);
+                }
+            }
+        }
+    }
+}
+
+// Add the active cells of the map to the universe
+// (originX, originY: position of the top left cell of the map in the universe)
+void mapToUniverse(Universe * u, const Bitmap * map, int originX, int originY){
+    uint64_t word;
+    for(int y = 0; y < map->height; y++){
+        for(int w = 0; w < map->words; w++){
+            for(word = mapRow(map, y)[w]; word != 0; word &= word - 1){
+                setUniverseCell(u, originX + w * WORD_BITS + __builtin_ctzll(word), originY + y, 1);
+            }
+        }
+    }
+}
+
+// Replace the content of the HashLife universe with the universe
+// (the nodes are built from the tiles, the empty area between them takes no memory)
+void universeToHashLife(const Universe * u, HashLife * hl){
+    HashLifeTile * tiles = malloc(((size_t)u->numOfTiles + 1) * sizeof(HashLifeTile));
+    if(tiles == NULL){
+        notEnoughMemory();
+    }
+    for(int i = 0; i < u->numOfTiles; i++){
+        tiles[i].x = u->tiles[i]->x;
+        tiles[i].y = u->tiles[i]->y;
+        tiles[i].rows = u->tiles[i]->cells;
+    }
+    tilesToHashLife(hl, tiles, u->numOfTiles);
+    free(tiles);
+}
+
+// Add the active cells of the node to the universe
+// (the cells outside of the coordinate range of the universe are dropped)
+// Return: Number of dropped cells
+static uint64_t nodeToUniverse(const Node * n, Universe * u, int64_t x, int64_t y){
+    int64_t size = (int64_t)1 << n->level;
+    int64_t half = size / 2;
+    if(n->population == 0){
+        return 0;
+    }
+    if(x > INT_MAX || y > INT_MAX || x + size - 1 < INT_MIN || y + size - 1 < INT_MIN){
+        return n->population;
+    }
+    if(n->level == 0){
+        setUniverseCell(u, (int)x, (int)y, 1);
+        return 0;
+    }
+    return nodeToUniverse(n->nw, u, x, y) +
+           nodeToUniverse(n->ne, u, x + half, y) +
+           nodeToUniverse(n->sw, u, x, y + half) +
+           nodeToUniverse(n->se, u, x + half, y + half);
+}
+
+// Replace the content of the universe with the HashLife universe
+// (the cells that left the coordinate range of the universe are dropped)
+void hashLifeToUniverse(HashLife * hl, Universe * u){
+    uint64_t dropped;
+    clearUniverse(u);
+    dropped = nodeToUniverse(hl->root, u, hl->originX, hl->originY);
+    if(dropped > 0){
+        printf("HashLife: %llu cells left the coordinate range of the plane and were dropped\n", (unsigned long long)dropped);
+    }
+}
+
+// Number of bytes allocated by the universe
+// Return: Size in bytes
+size_t universeSize(const Universe * u){
+    return sizeof(Universe) + u->numOfBuckets * sizeof(Tile *) +
+           u->capacity * sizeof(Tile *) + (size_t)u->numOfTiles * sizeof(Tile);
+}
+
+// Count the active cells of the universe (from the population of the tiles)
+// Return: Number of active cells
+long long universePopulation(const Universe * u){
+    long long population = 0;
+    for(int i = 0; i < u->numOfTiles; i++){
+        population += u->tiles[i]->stats.population;
+    }
+    return population;
+}
\ No newline at end of file
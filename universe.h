@@ -0,0 +1,97 @@
+#ifndef UNIVERSE_H
+#define UNIVERSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "bitmap.h"
+#include "kernel.h"
+#include "threadPool.h"
+#include "hashlife.h"
+#include "rule.h"
+#include "stats.h"
+
+// Number of cells in a row and in a column of a tile
+#define UNIVERSE_TILE_SIZE 64
+
+// Square area of the unbounded plane
+// Tiles are allocated when activity reaches them and freed when they become empty
+typedef struct Tile{
+    int x;                                // Column of the tile (cells x*64 ... x*64+63)
+    int y;                                // Row of the tile
+    uint64_t cells[UNIVERSE_TILE_SIZE];   // Rows of the tile (bit i is the cell in column x*64+i)
+    uint64_t next[UNIVERSE_TILE_SIZE];    // Next state of the rows
+    TileStats stats;                      // Population, used columns and rows, births and deaths of the last step
+    int index;                            // Position in the list of tiles
+    struct Tile * chain;                  // Next tile in the same hash bucket
+} Tile;
+
+// Unbounded plane stored as a hash map of tiles
+typedef struct Universe{
+    Tile ** buckets;        // Hash table of the tiles (indexed by position)
+    size_t numOfBuckets;    // Size of the hash table (power of two)
+    Tile ** tiles;          // List of the tiles
+    int numOfTiles;         // Number of tiles
+    int capacity;           // Size of the list
+} Universe;
+
+// Initialize an empty universe
+// Return: Pointer to the universe
+Universe * universe_init();
+
+// Frees the memory allocated by the universe
+void universe_free(Universe * u);
+
+// Remove every tile
+void clearUniverse(Universe * u);
+
+// Copy the content of the universe to another
+void copyUniverse(Universe * dst, const Universe * src);
+
+// Get the tile at the given position
+// Return: Pointer to the tile, or NULL if it is not allocated
+Tile * findTile(const Universe * u, int x, int y);
+
+// Get the state of the cell
+// Return: 1 if the cell is active, 0 otherwise
+int getUniverseCell(const Universe * u, int x, int y);
+
+// Set the state of the cell
+// (the population and the used columns and rows of the tile are updated)
+void setUniverseCell(Universe * u, int x, int y, int state);
+
+// Advance the universe to the next state with the given rule
+// (pool: threads that calculate the tiles, NULL: single threaded)
+// stats: the births, the deaths and the calculated and changed tiles of the step are added to it
+void stepUniverse(Universe * u, ThreadPool * pool, Rule rule, CellStats * stats);
+
+// Get the smallest rectangle that contains every active cell
+// (it is found from the statistics of the tiles, without reading the cells)
+// Return: TRUE if there are active cells, FALSE if the universe is empty
+bool universeBounds(const Universe * u, int * x, int * y, int * width, int * height);
+
+// Copy the cells of the universe inside the area of the map to the map
+// (originX, originY: position of the top left cell of the map in the universe)
+void universeToMap(const Universe * u, Bitmap * map, int originX, int originY);
+
+// Add the active cells of the map to the universe
+// (originX, originY: position of the top left cell of the map in the universe)
+void mapToUniverse(Universe * u, const Bitmap * map, int originX, int originY);
+
+// Replace the content of the HashLife universe with the universe
+// (the nodes are built from the tiles, the empty area between them takes no memory)
+void universeToHashLife(const Universe * u, HashLife * hl);
+
+// Replace the content of the universe with the HashLife universe
+// (the cells that left the coordinate range of the universe are dropped)
+void hashLifeToUniverse(HashLife * hl, Universe * u);
+
+// Number of bytes allocated by the universe
+// Return: Size in bytes
+size_t universeSize(const Universe * u);
+
+// Count the active cells of the universe (from the population of the tiles)
+// Return: Number of active cells
+long long universePopulation(const Universe * u);
+
+#endif
\ No newline at end of file